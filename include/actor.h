@@ -0,0 +1,85 @@
+#ifndef ACTOR_H
+#define ACTOR_H
+
+#include "addr_pool.h"
+#include "util.h"
+
+#define MAX_ACTORS 64
+#define ACTOR_RING_SIZE 256        // Commands per ring, power of two
+#define ACTOR_SPIN_LIMIT 1024      // Empty polls before an idle actor sleeps on its ring
+#define ACTOR_TSC_ROUNDS 64        // Round trips per TSC offset measurement
+#define ACTOR_GROUP_LEAD 20000     // Cycles from release to the deadline, enough to cross sockets
+
+typedef enum {
+    ACTOR_READ,
+    ACTOR_WRITE,
+    ACTOR_FLUSH,
+    ACTOR_ATOMIC,
+    ACTOR_WAIT,    // Barrier: wait until a peer completed what was queued to it
+    ACTOR_AT,      // Arrive at a group, then hold until its TSC deadline
+    ACTOR_TSC_PROBE,
+    ACTOR_CALL,    // Run a benchmark's own loop on the actor's core
+    ACTOR_STOP
+} actor_op_t;
+
+struct actor;
+struct timing_buffer;
+
+// Actors released together: each arrives and spins, the orchestrator
+// publishes a deadline once all have arrived, and each starts when its own
+// TSC, corrected by its measured offset, reaches it
+typedef struct actor_group {
+    uint32_t arrived __attribute__((aligned(CACHE_LINE_SIZE)));
+    int expected;
+    uint64_t deadline __attribute__((aligned(CACHE_LINE_SIZE)));  // Orchestrator TSC, 0 until released
+} actor_group_t;
+
+typedef struct {
+    actor_op_t op;
+    uint32_t first;
+    uint32_t count;
+    const pool_list_t *list;  // Lines list[first, first + count), or
+    void *const *lines;       // lines[first, first + count), or
+    void *line;               // a single line when both are NULL
+    struct actor *peer;       // ACTOR_WAIT
+    uint32_t peer_done;
+    actor_group_t *group;     // ACTOR_AT
+    struct timing_buffer *buf;  // Time each access into buf, keyed key + i
+    uint32_t key;
+    void (*fn)(void *arg);    // ACTOR_CALL
+    void *arg;
+} actor_cmd_t;
+
+// One long-lived thread pinned to a core, fed by the orchestrator through a
+// single-producer/single-consumer ring. head is written only by the
+// orchestrator, tail (commands completed) only by the actor.
+typedef struct actor {
+    int core_id;
+    pthread_t thread;
+    int64_t tsc_offset;         // Actor's TSC minus the orchestrator's
+    int tsc_measured;
+    uint32_t head __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint32_t sleeping;
+    uint32_t tail __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint64_t start_tsc;         // When the last ACTOR_AT released, orchestrator TSC
+    actor_cmd_t ring[ACTOR_RING_SIZE] __attribute__((aligned(CACHE_LINE_SIZE)));
+} actor_t;
+
+actor_t *actor_get(int core_id);
+void actor_submit(actor_t *actor, actor_op_t op, const pool_list_t *list, uint32_t first, uint32_t count);
+void actor_submit_lines(actor_t *actor, actor_op_t op, void *const *lines, uint32_t count);
+void actor_submit_line(actor_t *actor, actor_op_t op, void *line);
+void actor_submit_timed(actor_t *actor, actor_op_t op, const pool_list_t *list, uint32_t first, uint32_t count,
+                        struct timing_buffer *buf, uint32_t key);
+void actor_call(actor_t *actor, void (*fn)(void *), void *arg);
+void actor_after(actor_t *actor, actor_t *peer);
+int64_t actor_tsc_offset(actor_t *actor);
+void actor_group_init(actor_group_t *group);
+void actor_at(actor_t *actor, actor_group_t *group);
+uint64_t actor_group_release(actor_group_t *group, uint64_t lead_cycles);
+void actor_group_cancel(actor_group_t *group, actor_t *const *members, int count);
+void actor_sync(actor_t *actor);
+void actor_sync_all();
+void actor_stop_all();
+
+#endif // ACTOR_H
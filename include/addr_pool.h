@@ -0,0 +1,56 @@
+#ifndef ADDR_POOL_H
+#define ADDR_POOL_H
+
+#include <stdint.h>
+#include "msr_defs.h"
+
+#define POOL_FILE "cha_pool.bin"            // Exported pool, reloaded with --reuse-pool
+#define POOL_FILE_MAGIC 0x4C4F4F5041484343UL // "CCHAPOOL"
+#define POOL_FILE_VERSION 1
+
+// Lines homed at one CHA of one socket. Offsets are 32-bit and relative to
+// the node buffer that holds them; after addr_pool_finalize() they are sorted
+// by L3 slice set and set_start[] indexes the run of each set.
+typedef struct {
+    uint32_t *offsets;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *set_start;  // [L3_SLICE_SETS + 1]
+    uint8_t *base;        // node_buffers[node]
+    int node;
+} pool_list_t;
+
+typedef struct {
+    int num_sockets;
+    int finalized;
+    pool_list_t lists[MAX_SOCKETS][NUM_CHA];
+} addr_pool_t;
+
+extern int pool_lines_per_cha;  // Lines collected per CHA by the mapping
+
+void addr_pool_init(addr_pool_t *pool, int num_sockets);
+void addr_pool_free(addr_pool_t *pool);
+int addr_pool_add(addr_pool_t *pool, int socket_id, int cha, int node, uint8_t *base, void *line);
+void addr_pool_finalize(addr_pool_t *pool);
+int addr_pool_save(const addr_pool_t *pool, const char *path);
+int addr_pool_load(addr_pool_t *pool, const char *path);
+
+// Bounds-checked accessors
+const pool_list_t *pool_list(const addr_pool_t *pool, int socket_id, int cha);
+uint32_t pool_count(const addr_pool_t *pool, int socket_id, int cha);
+void *pool_addr(const addr_pool_t *pool, int socket_id, int cha, uint32_t idx);
+uint32_t pool_set_range(const addr_pool_t *pool, int socket_id, int cha, int set, uint32_t *first);
+
+// Unchecked access for benchmark hot loops (idx < list->count)
+static inline void *pool_line(const pool_list_t *list, uint32_t idx) {
+    return list->base + list->offsets[idx];
+}
+
+// Fixed socket ids in benchmarks are written for four sockets; fold them onto
+// the sockets that actually exist. Socket parameters are checked instead
+// (bench_param_socket).
+static inline int pool_socket(const addr_pool_t *pool, int socket_id) {
+    return socket_id % pool->num_sockets;
+}
+
+#endif // ADDR_POOL_H
@@ -11,6 +11,7 @@
 
 #define JSON_FILE_PATH "events/cha_events_clx_parsed.json" // Path to events json file
 #define OFFSET_FILE "cha_map_clx_mammoth.log" 
+#define LLC_LOOKUP_READ_EVENT "UNC_CHA_LLC_LOOKUP.DATA_READ"   // LLC read lookups, any state
 
 // Global Performance Monitoring Control MSRs
 #define U_MSR_PMON_GLOBAL_CTL          0x0700L       // contains bits that can stop (.frz_all) / restart (.unfrz_all) all the uncore counters
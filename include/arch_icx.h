@@ -11,6 +11,8 @@
 
 #define JSON_FILE_PATH "events/cha_events_icx_parsed.json" // Path to events json file
 #define OFFSET_FILE "cha_map_icx_mammoth.log" 
+#define LLC_LOOKUP_READ_EVENT "UNC_CHA_LLC_LOOKUP.DATA_READ_ALL"   // LLC read lookups, any state
+#define LLC_LOOKUP_MISS_EVENT "UNC_CHA_LLC_LOOKUP.DATA_READ_MISS"  // LLC read lookups that missed
 
 // Global Performance Monitoring Control MSRs
 #define U_MSR_PMON_GLOBAL_CTL          0x0700L       // contains bits that can stop (.frz_all) / restart (.unfrz_all) all the uncore counters
@@ -61,4 +63,23 @@
 // Unit PMON state - Control event bits (8 bits [7:0])
 #define MSR_UNIT_CTL_EVENT(event)   (event)
 
+
+// Cache Configurations
+#define L1_SIZE (48 * 1024)                   // 48 KB
+#define L2_SIZE ((1 * 1024 * 1024) + (256 * 1024))  // 1.25 MB
+#define L3_SLICE_SIZE ((1 * 1024 * 1024) + (512 * 1024))  // 1.5 MB per CHA
+#define L3_SIZE (L3_SLICE_SIZE * NUM_CHA)
+
+#define L1_ASSOC 12
+#define L2_ASSOC 20
+#define L3_ASSOC 12
+
+#define L1_SETS (L1_SIZE / (64 * L1_ASSOC))
+#define L2_SETS (L2_SIZE / (64 * L2_ASSOC))
+#define L3_SLICE_SETS (L3_SLICE_SIZE / (64 * L3_ASSOC))
+
+#define L1_SET_INDEX_MASK 0xFC0 // 6 bits - [11-6] - 64 sets + 12 way for each core
+#define L2_SET_INDEX_MASK 0xFFC0 // 10 bits - [15-6] - 1024 sets + 20 way for each core
+#define L3_SLICE_SET_INDEX_MASK 0x1FFC0 // 11 bits - [16-6] - 2048 sets + 12 way for each slice
+
 #endif // ARCH_DETAIL_ICELAKEX_H
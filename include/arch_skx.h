@@ -10,6 +10,7 @@
 #define NUM_CTR_PER_CHA 4
 
 #define JSON_FILE_PATH "cha_events_skx.json" // Path to events json file
+#define LLC_LOOKUP_READ_EVENT "UNC_CHA_LLC_LOOKUP.DATA_READ"   // LLC read lookups, any state
 
 // Global Performance Monitoring Control MSRs
 #define U_MSR_PMON_GLOBAL_CTL          0x0700L       // contains bits that can stop (.frz_all) / restart (.unfrz_all) all the uncore counters
@@ -54,4 +55,22 @@
 // Unit PMON state - Control event bits (8 bits [7:0])
 #define MSR_UNIT_CTL_EVENT(event)   (event)
 
+// Cache Configurations
+#define L1_SIZE (32 * 1024)           // 32 KB
+#define L2_SIZE (1 * 1024 * 1024)     // 1 MB
+#define L3_SLICE_SIZE ((1 * 1024 * 1024) + (384 * 1024))  // 1.375 MB per CHA
+#define L3_SIZE (L3_SLICE_SIZE * NUM_CHA)
+
+#define L1_ASSOC 8
+#define L2_ASSOC 16
+#define L3_ASSOC 11
+
+#define L1_SETS (L1_SIZE / (64 * L1_ASSOC))
+#define L2_SETS (L2_SIZE / (64 * L2_ASSOC))
+#define L3_SLICE_SETS (L3_SLICE_SIZE / (64 * L3_ASSOC))
+
+#define L1_SET_INDEX_MASK 0xFC0 // 6 bits - [11-6] - 64 sets + 8 way for each core
+#define L2_SET_INDEX_MASK 0xFFC0 // 10 bits - [15-6] - 1024 sets + 16 way for each core
+#define L3_SLICE_SET_INDEX_MASK 0x1FFC0 // 11 bits - [16-6] - 2048 sets + 11 way for each slice
+
 #endif // ARCH_DETAIL_SKYLAKEX_H
@@ -3,8 +3,11 @@
 
 #include <stdio.h>
 #include "socket_memory.h"
+#include "actor.h"
+#include "phase.h"
 #include "util.h"
 
+// v1: exported as the 'benchmark' symbol
 typedef struct {
     const char *name;
     void (*init)(void*, int*, int*, int*);    // Pass core arrays dynamically
@@ -12,13 +15,80 @@ typedef struct {
     void (*cleanup)(void*, int*, int*, int*);
 } Benchmark;
 
+#define BENCHMARK_ABI_VERSION 2
+#define MAX_BENCH_PARAMS 16
+#define MAX_BENCH_METRICS 32
+
+typedef struct {
+    char key[32];
+    char value[64];
+} bench_param_t;
+
+// Metric reported by the benchmark, aggregated over the runs of a session
+typedef struct {
+    char name[48];
+    char unit[16];
+    double sum;
+    double min;
+    double max;
+    uint64_t samples;
+} bench_metric_t;
+
+// Everything a v2 benchmark gets from the driver
+typedef struct bench_ctx {
+    int abi_version;
+    const void *benchmark;      // Loader entry being run
+    int num_sockets;
+    int num_chas;
+    addr_pool_t *pool;
+    int *primary_cores;
+    int *secondary_cores;
+    int *orchestrator_cores;
+    actor_t *primary_actors[MAX_SOCKETS];     // Started on first bench_actor()
+    actor_t *secondary_actors[MAX_SOCKETS];
+    bench_param_t params[MAX_BENCH_PARAMS];   // --param key=value
+    int num_params;
+    bench_metric_t metrics[MAX_BENCH_METRICS];
+    int num_metrics;
+    int run;                    // Run within the current monitoring session
+    void (*mark_phase)(int phase);  // From the ROI: snapshot the counters, phase N starts
+    void *priv;                 // Benchmark's own state
+} bench_ctx_t;
+
+// v2: exported as the 'benchmark_v2' symbol, preferred over 'benchmark'
+typedef struct {
+    int abi_version;                    // BENCHMARK_ABI_VERSION
+    const char *name;
+    int (*setup)(bench_ctx_t*);         // Optional, once per parameter set; nonzero skips the set
+    void (*init)(bench_ctx_t*);
+    void (*roi)(bench_ctx_t*);
+    void (*cleanup)(bench_ctx_t*);
+    void (*teardown)(bench_ctx_t*);     // Optional, after the last run of a parameter set
+} BenchmarkV2;
+
 // Extern reference to benchmarks array (populated dynamically in benchmark.c)
-extern Benchmark *benchmarks[];
 extern int num_benchmarks;
 
 // Function prototypes
-Benchmark* get_benchmark_by_name(const char *name);
+const BenchmarkV2* get_benchmark_by_name(const char *name);
+const char *benchmark_source(const BenchmarkV2 *benchmark);
 void list_available_benchmarks();
 void load_benchmarks();
+const BenchmarkV2* load_benchmark(const char *name);
+int reload_benchmark(const char *name);
+const BenchmarkV2 *benchmark_at(int index);
+
+void bench_ctx_init(bench_ctx_t *ctx, const BenchmarkV2 *benchmark, addr_pool_t *pool, int num_sockets);
+int bench_param_set(bench_ctx_t *ctx, const char *key, const char *value);
+int bench_param_parse(bench_ctx_t *ctx, const char *assignment);
+const char *bench_param(const bench_ctx_t *ctx, const char *key, const char *fallback);
+long bench_param_long(const bench_ctx_t *ctx, const char *key, long fallback);
+int bench_param_socket(const bench_ctx_t *ctx, const char *key, int fallback);
+int bench_param_cores(const bench_ctx_t *ctx, const char *key, int socket_id, int wanted, int exclude_core,
+                      int *cores, int max_cores);
+uint32_t *bench_shuffled_order(uint32_t n, uint64_t seed);
+actor_t *bench_actor(bench_ctx_t *ctx, int socket_id, int secondary);
+void bench_report(bench_ctx_t *ctx, const char *name, double value, const char *unit);
+void bench_print_metrics(bench_ctx_t *ctx);
 
 #endif // BENCHMARK_H
@@ -0,0 +1,26 @@
+#ifndef CURVE_H
+#define CURVE_H
+
+#define CURVE_DIR "output/current"
+#define CURVE_KEY_LEN 384     // Room for a list of every core of a socket
+#define CURVE_VALUES 2          // Measured values per point
+#define MAX_CURVES 32
+#define MAX_CURVE_POINTS 64
+
+// What one parameter set measured at one value of the swept parameter
+typedef struct {
+    double x;
+    double y[CURVE_VALUES];
+} curve_point_t;
+
+// Points of one configuration (every parameter but the swept one), by x
+typedef struct {
+    char key[CURVE_KEY_LEN];
+    curve_point_t points[MAX_CURVE_POINTS];
+    int num_points;
+} curve_t;
+
+int curve_add_point(const char *name, const char *key, const curve_point_t *point);
+int curve_load(const char *name, curve_t *curves, int max_curves);
+
+#endif // CURVE_H
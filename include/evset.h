@@ -0,0 +1,62 @@
+#ifndef EVSET_H
+#define EVSET_H
+
+#include "socket_memory.h"
+
+#define EVSET_MAX_LINES (4 * L3_ASSOC)  // Congruent candidates gathered before reduction
+#define EVSET_MAX_PRESETS 16            // Sets built before monitoring with --evset
+#define EVSET_SCAN_LIMIT 4096           // Set-congruent lines probed with the CHA counters
+#define EVSET_TRIALS 9                  // Timed trials per eviction test (majority vote)
+#define EVSET_PASSES 3                  // Traversals of the set per trial
+#define EVSET_CALIBRATION_REPS 15
+
+#define PRIVATE_EVSET_LINES (2 * L2_ASSOC)          // Lines congruent with the target in L1 and L2
+#define PRIVATE_SCRATCH_SIZE (16L * 1024 * 1024)    // Candidate lines for private eviction sets
+
+#define NEAR_CHA_LINES 8    // Lines of the target CHA timed per core
+#define NEAR_CHA_REPS 5
+
+// Lines homed at one CHA that share one L3 slice set. After evset_build()
+// the set is reduced to (at most a few more than) L3_ASSOC lines that still
+// evict target from the LLC.
+typedef struct {
+    int socket_id;
+    int cha;
+    int set;        // Physical L3 slice set index
+    void *target;   // Congruent line the set was validated against
+    uint64_t threshold;  // Cycles above which an access to target missed the LLC
+    int count;
+    void *lines[EVSET_MAX_LINES];
+} evset_t;
+
+// Lines that share the target's L1 and L2 sets but not its L3 slice set.
+// Traversing them pushes the target out of the core's private caches while
+// it stays in the LLC, unlike flush().
+typedef struct {
+    void *target;
+    int count;
+    void *lines[PRIVATE_EVSET_LINES];
+} private_evset_t;
+
+extern evset_t evsets[EVSET_MAX_PRESETS];
+extern int num_evsets;
+
+int l3_slice_set(void *addr);
+uint64_t evset_calibrate(void *target);
+void evset_traverse(const evset_t *evset);
+int evset_evicts(const evset_t *evset, void *target);
+
+// Candidates come from the address pool first. If msr_fds is given, further
+// set-congruent lines of the CHA's node buffer are identified with the CHA
+// counters; that reprograms them, so only do it outside a monitoring session.
+int evset_build(evset_t *evset, const addr_pool_t *pool, int socket_id, int cha, int set,
+                int* msr_fds, int num_sockets, cha_event_t* events, int num_events);
+const evset_t *evset_lookup(int socket_id, int cha, int set);
+
+int private_evset_build(private_evset_t *pe, void *target);
+void evict_to_llc(const private_evset_t *pe);
+int verify_llc_hit(const private_evset_t *pe, int socket_id, int cha,
+                   int* msr_fds, int num_sockets, cha_event_t* events, int num_events);
+int select_cores_near_cha(const addr_pool_t *pool, int socket_id, int cha);
+
+#endif // EVSET_H
@@ -0,0 +1,57 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "util.h"
+#include "msr_defs.h"
+
+// Log-linear buckets in the HDR style: values below 2 * HIST_SUB_BUCKETS
+// are exact, above that each power of two is split into HIST_SUB_BUCKETS
+// buckets (about 3% relative error). Values are clamped to HIST_MAX_VALUE.
+#define HIST_SUB_BITS 5
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 24
+#define HIST_MAX_VALUE ((1ull << HIST_MAX_BITS) - 1)
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS)
+
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+} histogram_t;
+
+// One histogram per (requester socket, home socket, CHA)
+typedef struct {
+    histogram_t h[MAX_SOCKETS][MAX_SOCKETS][NUM_CHA];
+} latency_hist_t;
+
+static inline uint32_t hist_bucket(uint64_t value) {
+    if (value > HIST_MAX_VALUE) value = HIST_MAX_VALUE;
+    if (value < 2 * HIST_SUB_BUCKETS) return value;
+    uint32_t shift = 63 - __builtin_clzll(value) - HIST_SUB_BITS;
+    return shift * HIST_SUB_BUCKETS + (value >> shift);
+}
+
+// Fixed-size, allocation-free
+static inline void hist_record(histogram_t *hist, uint64_t value) {
+    hist->counts[hist_bucket(value)]++;
+    if (hist->total == 0 || value < hist->min) hist->min = value;
+    if (value > hist->max) hist->max = value;
+    hist->total++;
+}
+
+static inline void latency_hist_record(latency_hist_t *lh, int req, int home, int cha, uint64_t value) {
+    if (req < MAX_SOCKETS && home < MAX_SOCKETS && cha < NUM_CHA) {
+        hist_record(&lh->h[req][home][cha], value);
+    }
+}
+
+void hist_reset(histogram_t *hist);
+void hist_merge(histogram_t *dst, const histogram_t *src);
+uint64_t hist_percentile(const histogram_t *hist, double percentile);
+void latency_hist_merge(latency_hist_t *dst, const latency_hist_t *src);
+void latency_hist_report(const latency_hist_t *lh, const char *label, FILE *out);
+
+#endif // HISTOGRAM_H
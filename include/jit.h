@@ -0,0 +1,31 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "actor.h"
+
+// Flags for jit_build
+#define JIT_TABLE   0x1    // Load addresses from a packed table instead of immediates
+#define JIT_MFENCE  0x2    // mfence after every access
+#define JIT_LFENCE  0x4    // lfence after every access
+#define JIT_TIMED   0x8    // rdtscp around every access, cycles stored per access
+
+typedef void (*jit_fn_t)(void *const *table, uint64_t *cycles);
+
+// Straight-line kernel for a fixed address sequence: no loop, no branches,
+// no calls between the first and last access
+typedef struct {
+    jit_fn_t fn;
+    void *code;
+    size_t size;
+    void **table;       // JIT_TABLE: packed addresses, in access order
+    uint64_t *cycles;   // JIT_TIMED: cycles of each access
+    uint32_t count;
+    unsigned flags;
+} jit_kernel_t;
+
+jit_kernel_t *jit_build(void *const *lines, const actor_op_t *ops, actor_op_t op, uint32_t count, unsigned flags);
+void jit_free(jit_kernel_t *kernel);
+
+static inline void jit_run(const jit_kernel_t *kernel) { kernel->fn(kernel->table, kernel->cycles); }
+
+#endif // JIT_H
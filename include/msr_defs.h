@@ -9,6 +9,7 @@
 #include "util.h"
 
 #define NUM_RUNS 10
+#define MAX_RUNS 64            // Run cap of the adaptive mode
 #define MAX_MONITOR_EVENTS 10  // Maximum number of counters to monitor
 #define MAX_ADDRESSES 45
 
@@ -64,7 +65,7 @@ void read_cha_counters(
     char* event_name_list[],
     int num_events_to_program,
     int run_idx,
-    uint64_t counts[NUM_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS],
+    uint64_t counts[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS],
   int event_index);
 void calculate_cha_counters(
     uint64_t old_counts[NUM_RUNS][MAX_SOCKETS][NUM_CHA][NUM_CTR_PER_CHA],
@@ -73,7 +74,8 @@ void calculate_cha_counters(
     int num_events_to_program,
     int num_sockets);
 void write_event_counts(
-    uint64_t counts[NUM_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS],
+    uint64_t counts[MAX_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS],
+    const int runs[MAX_MONITOR_EVENTS],
     int num_events_to_program,
     int num_sockets,
     char** event_name_list,
@@ -102,5 +104,6 @@ void select_cha_events(cha_event_t *events, int num_events,
     char ***event_name_list, int *num_events_to_program);
 
 void disable_prefetch(int* msr_fds, int num_sockets);
+int create_directory_recursively(const char* path);
 
 #endif  // MSR_DEFS_H
\ No newline at end of file
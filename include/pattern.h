@@ -0,0 +1,58 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include "addr_pool.h"
+#include "actor.h"
+#include "jit.h"
+
+#define PATTERN_DIR "patterns/"     // Access-pattern specs, loaded as benchmarks
+#define MAX_PATTERN_PHASES 32
+#define MAX_PATTERN_ACTORS 4        // Actors taking turns on each line of a phase
+
+typedef enum { PATTERN_INIT, PATTERN_ROI, PATTERN_CLEANUP } pattern_stage_t;
+typedef enum { ORDER_CHA, ORDER_ADDRESS } pattern_order_t;   // CHA-major or address-major
+typedef enum { ROLE_PRIMARY, ROLE_SECONDARY, ROLE_ORCHESTRATOR, ROLE_CALLER } pattern_role_t;
+
+typedef struct {
+    pattern_role_t role;
+    int socket;
+    int migrate;    // Run on the calling thread, moved to the role's core
+} pattern_actor_t;
+
+// One phase of a spec and, once compiled, its flat line array
+typedef struct {
+    pattern_stage_t stage;
+    actor_op_t op;
+    pattern_actor_t actors[MAX_PATTERN_ACTORS];
+    int num_actors;
+    int socket;             // Home socket of the lines
+    int chas[NUM_CHA];
+    int num_chas;
+    uint32_t first;         // First line of each CHA
+    uint32_t count;         // Lines per CHA, 0 for all
+    pattern_order_t order;
+    int fence;
+    int timed;
+
+    void **lines;
+    uint32_t num_lines;
+    jit_kernel_t *kernel;   // Calling-thread ROI phases run as straight-line code
+    uint64_t cycles;
+    uint64_t samples;
+} pattern_phase_t;
+
+typedef struct {
+    char name[64];
+    pattern_phase_t phases[MAX_PATTERN_PHASES];
+    int num_phases;
+    int compiled;
+} pattern_t;
+
+int pattern_spec_name(const char *path, char *name, size_t len);
+int pattern_load(const char *path);
+
+void pattern_init(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores);
+void pattern_roi(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores);
+void pattern_cleanup(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores);
+
+#endif // PATTERN_H
@@ -0,0 +1,23 @@
+#ifndef PHASE_H
+#define PHASE_H
+
+#include "msr_defs.h"
+
+#define MAX_PHASES 8
+
+// Per-phase counts of the current session, in the layout write_event_counts
+// takes; phase p counts from mark p (or the unfreeze, for p = 0) to the
+// next mark or the final freeze
+extern uint64_t phase_counts[MAX_PHASES][MAX_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS];
+extern int num_phases;
+
+void phase_session(int *msr_fds, int num_sockets, cha_event_t *events, int num_events,
+                   char **event_group, int num_events_to_program, int event_index);
+void phase_begin_run(int run_idx);
+void phase_end_run(uint64_t counts[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS]);
+void phase_reset();
+
+// Called from a benchmark's ROI: phase N starts now
+void bench_mark_phase(int phase);
+
+#endif // PHASE_H
@@ -0,0 +1,25 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "session.h"
+
+#define SERVER_SOCKET "msr_program.sock"
+#define SERVER_MAX_REQUEST 65536
+#define SERVER_READ_TIMEOUT 5       // Seconds a client may take to send its request
+
+// Warm server: startup (buffers, CHA map, catalog) is paid once, then one
+// JSON request per connection on a Unix socket, answered with one JSON line.
+//
+//   {"benchmark": "benchmark3", "events": ["UNC_CHA_TOR_INSERTS.IA_MISS"], "runs": 5,
+//    "params": {"cha": 7}, "name": "b3_cha7", "reload": true}
+//     -> {"status": "ok", "results": ["output/current/b3_cha7.log"]}
+//   {"cmd": "list"}                            -> {"status": "ok", "benchmarks": [...]}
+//   {"cmd": "reload", "benchmark": "..."}      -> {"status": "ok"}
+//   {"cmd": "shutdown"}
+//
+// Only "benchmark" is required; the rest default to the server's own options.
+// reload reopens the benchmark's .so (or rescans bin/ for a new one) first.
+int server_run(const char *socket_path, const session_t *s, const bench_ctx_t *base,
+               char **event_name_list, int num_total_events);
+
+#endif // SERVER_H
@@ -0,0 +1,35 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "benchmark.h"
+#include "msr_defs.h"
+
+typedef enum { BASELINE_NONE, BASELINE_NOOP, BASELINE_INIT } baseline_mode_t;
+
+// How each monitoring session is run, fixed for the process
+typedef struct {
+    int *msr_fds;
+    int num_sockets;
+    cha_event_t *events;
+    int num_events;
+    int runs;                   // Kept runs per event group without --adaptive
+    int warmup_runs;
+    double adaptive_width;      // Target relative CI width, 0 for fixed runs
+    int max_runs;
+    baseline_mode_t baseline;
+    int baseline_runs;
+} session_t;
+
+// Counts of the last session, in the layout write_event_counts takes
+extern uint64_t new_counts[MAX_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS];
+extern int runs_per_event[MAX_MONITOR_EVENTS];
+
+int session_check_events(const session_t *s, char **event_name_list, int num_total_events);
+
+// Setup, every event group over the runs, reports under output/current/<output_name>*, teardown.
+// Returns nonzero if an event is not in the catalog or the benchmark's setup
+// rejected the parameter set.
+int run_session(const session_t *s, const BenchmarkV2 *benchmark, bench_ctx_t *ctx,
+                char **event_name_list, int num_total_events, const char *output_name);
+
+#endif // SESSION_H
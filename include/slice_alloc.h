@@ -0,0 +1,39 @@
+#ifndef SLICE_ALLOC_H
+#define SLICE_ALLOC_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "socket_memory.h"
+
+#define SLICE_MAX_CORES 1024   // Upper bound on core ids cached by slice_nearest_cha
+#define SLICE_PROBE_LINES 8    // Lines per CHA timed when locating the nearest CHA
+#define SLICE_PROBE_REPS 5     // Repetitions per probed line (minimum is kept)
+
+// Per-slice allocator statistics
+typedef struct {
+    size_t capacity;      // Lines owned by the slice pool
+    size_t free;          // Lines currently on the free list
+    size_t in_use;        // Live objects
+    size_t peak_in_use;   // High-water mark of live objects
+    size_t allocs;        // Successful allocations
+    size_t frees;         // Objects returned
+    size_t failed;        // Requests that found the free list empty
+    size_t pages_in_use;  // Distinct 4KB pages spanned by live objects
+} slice_alloc_stats_t;
+
+// Pools are seeded from the CHA mapping (the address pool handed to
+// benchmarks) of a socket buffer. Objects are single cache lines; the free
+// list is kept out of band so free lines are never written by the allocator.
+int slice_alloc_init(const addr_pool_t *pool, int socket_id);
+int slice_alloc_add_lines(int socket_id, int cha, void **lines, int count);
+void slice_alloc_destroy();
+
+void *slice_alloc(int socket_id, int cha);
+void *slice_alloc_near_core(int socket_id, int core_id);
+void slice_free(void *ptr);
+
+int slice_nearest_cha(int socket_id, int core_id);
+void slice_alloc_get_stats(int socket_id, int cha, slice_alloc_stats_t *stats);
+void slice_alloc_print_stats(int socket_id, FILE *fp);
+
+#endif // SLICE_ALLOC_H
@@ -10,6 +10,8 @@
 #include <sys/mman.h>
 #include "msr_defs.h"
 #include "util.h"
+#include "topology.h"
+#include "addr_pool.h"
 
 #define MATCH_THRESHOLD 10  // Number of offsets to compare for reuse
 
@@ -17,16 +19,34 @@
 // #define PAGE_SIZE (2 * 1024 * 1024)  // 2MB HugePage size
 #define ALIGNMENT (2L * 1024 * 1024) // 2MB alignment
 
-extern void* address_list[MAX_SOCKETS][NUM_CHA][MAX_ADDRESSES];
+#define USE_HUGEPAGES 1            // Back socket buffers with 1GB/2MB hugetlbfs pages when available
+#define FIRST_TOUCH_THREADS 8      // Threads per node touching its buffer
+#define PROGRESS_INTERVAL_US 100000  // Progress bar refresh while buffers are touched
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+extern addr_pool_t address_pool;  // Lines of every (socket, CHA), from the CHA mapping
 extern uint8_t *socket_buffers[MAX_SOCKETS];
+extern uint8_t *node_buffers[MAX_NODES];
+extern int cha_node[MAX_SOCKETS][NUM_CHA];  // SNC node whose memory each CHA homes, -1 if unmapped
 
 void allocate_memory_per_socket();
 void free_memory_per_socket();
 void *get_socket_buffer(int socket_id);
 void access_flush_socket_memory_one(int socket_id);
 void access_socket_memory_hitmealloc(int socket_id);
-int load_stored_offsets(int stored_offsets[NUM_CHA][MAX_ADDRESSES], int* valid_entries);
 int find_cha_mapped_offset(void* address, int* msr_fds, int num_sockets, cha_event_t* events, int num_events);
 void generate_cha_mapped_offsets(int* msr_fds, int num_sockets, cha_event_t* events, int num_events);
+int validate_address_pool(addr_pool_t *pool, int* msr_fds, int num_sockets, cha_event_t* events, int num_events);
+void evict_private_caches();
+int get_locality_chas(int core_id, pool_locality_t locality, int *socket_id, int chas[NUM_CHA]);
 
 #endif // SOCKET_MEMORY_H
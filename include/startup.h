@@ -0,0 +1,29 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <time.h>
+
+#define MAX_STARTUP_STAGES 16
+
+// One step of process startup; fn returns nonzero on failure
+typedef struct {
+    const char *name;
+    int (*fn)(void *arg);
+    void *arg;
+    double seconds;             // Filled in when the stage has run
+    int status;
+    int parallel;               // Ran alongside other stages
+} startup_stage_t;
+
+typedef struct {
+    startup_stage_t stages[MAX_STARTUP_STAGES];
+    int num_stages;
+    struct timespec start;
+} startup_t;
+
+void startup_begin(startup_t *startup);
+int startup_serial(startup_t *startup, const char *name, int (*fn)(void *), void *arg);
+int startup_parallel(startup_t *startup, const startup_stage_t *stages, int num_stages);
+void startup_report(const startup_t *startup);
+
+#endif // STARTUP_H
@@ -0,0 +1,28 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "msr_defs.h"
+
+#define ADAPTIVE_MIN_RUNS 3          // Kept runs before convergence is checked
+#define ADAPTIVE_MIN_HALF_WIDTH 1.0  // Counts; CIs this narrow pass regardless of the mean
+
+// Mean and standard error of one (socket, CHA, event) over runs
+// [first, first + n)
+typedef struct {
+    double mean;
+    double sem;
+    int n;
+} run_stats_t;
+
+run_stats_t run_stats(uint64_t counts[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS], int first, int n,
+                      int socket, int cha, int event);
+double t_critical_95(int n);
+int counts_converged(uint64_t counts[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS], int n, int num_sockets,
+                     int event_index, int num_events, double rel_width);
+
+void write_baseline_report(uint64_t counts[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS], const int runs[],
+                           uint64_t baseline[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS], const int baseline_runs[],
+                           int num_events, int num_sockets, char **event_name_list, const char *benchmark_name,
+                           const char *mode);
+
+#endif // STATS_H
@@ -0,0 +1,29 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "session.h"
+
+#define SWEEP_OUTPUT_DIR "output"
+#define MAX_SWEEP_VALUES 256
+#define MAX_SWEEP_GROUPS 16
+
+// Sweep file, one monitoring session per (benchmark, parameter point,
+// event group):
+//
+//   {
+//     "name": "cha_scan",
+//     "benchmarks": ["benchmark3"],
+//     "params": {"cha": {"first": 0, "last": 39}, "home": [3, 7]},
+//     "events": [["UNC_CHA_TOR_INSERTS.IA"], ["UNC_CHA_TOR_INSERTS.IA_MISS"]]
+//   }
+//
+// params is a grid: each key takes a list of values or a first/last[/step]
+// range. events defaults to the monitor file. lines_per_cha, if given, is the
+// smallest --lines-per-cha the points fit in; the sweep refuses to start
+// with less. Completed points are appended
+// to output/<name>.checkpoint under a hash of everything they depend on, and
+// skipped when the same hash comes up again.
+int sweep_run(const char *path, const session_t *s, const bench_ctx_t *base,
+              char **event_name_list, int num_total_events);
+
+#endif // SWEEP_H
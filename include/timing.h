@@ -0,0 +1,106 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+#include <cpuid.h>
+#include "histogram.h"
+
+#define MAX_TIMING_BUFFERS 16
+#define TIMING_CALIBRATION_ROUNDS 10000
+
+// How a stamp is kept from reordering with the timed accesses
+typedef enum {
+    TIMING_LFENCE,    // lfence; rdtsc; lfence
+    TIMING_RDTSCP,    // rdtscp; lfence
+    TIMING_CPUID,     // cpuid; rdtsc to begin, rdtscp; cpuid to end
+    TIMING_NUM_MODES
+} timing_mode_t;
+
+// Pack (requester socket, home socket, CHA, index) into a sample key
+#define TIMING_KEY(req, home, cha, idx) \
+    (((uint32_t)(req) << 28) | ((uint32_t)(home) << 24) | ((uint32_t)(cha) << 16) | ((uint32_t)(idx) & 0xFFFF))
+#define TIMING_KEY_REQ(key)  ((key) >> 28)
+#define TIMING_KEY_HOME(key) (((key) >> 24) & 0xF)
+#define TIMING_KEY_CHA(key)  (((key) >> 16) & 0xFF)
+#define TIMING_KEY_IDX(key)  ((key) & 0xFFFF)
+
+typedef struct {
+    uint32_t key;
+    uint32_t cycles;    // Net of the stamp overhead
+} timing_sample_t;
+
+// Preallocated samples of one recording thread, handed to flush() once the
+// counters are frozen
+typedef struct timing_buffer {
+    const char *label;                          // Copied at creation
+    timing_mode_t mode;
+    timing_sample_t *samples;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t dropped;
+    void (*flush)(struct timing_buffer *buf);   // NULL: into hist if set, else a per-key summary
+    void *arg;
+    latency_hist_t *hist;                       // Accumulated over runs until timing_report_all
+    const void *owner;                          // Load base of the object that created the buffer
+} timing_buffer_t;
+
+extern uint64_t timing_overhead[TIMING_NUM_MODES];
+extern double tsc_ghz;
+
+static inline __attribute__((always_inline)) uint64_t timing_begin(timing_mode_t mode) {
+    uint32_t lo, hi, a, b, c, d;
+    switch (mode) {
+        case TIMING_RDTSCP:
+            asm volatile("rdtscp\n\tlfence" : "=a"(lo), "=d"(hi) :: "rcx", "memory");
+            break;
+        case TIMING_CPUID:
+            __cpuid(0, a, b, c, d);
+            asm volatile("rdtsc" : "=a"(lo), "=d"(hi) :: "memory");
+            break;
+        default:
+            asm volatile("lfence\n\trdtsc\n\tlfence" : "=a"(lo), "=d"(hi) :: "memory");
+            break;
+    }
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline __attribute__((always_inline)) uint64_t timing_end(timing_mode_t mode) {
+    uint32_t lo, hi, a, b, c, d;
+    switch (mode) {
+        case TIMING_RDTSCP:
+            asm volatile("rdtscp\n\tlfence" : "=a"(lo), "=d"(hi) :: "rcx", "memory");
+            break;
+        case TIMING_CPUID:
+            asm volatile("rdtscp" : "=a"(lo), "=d"(hi) :: "rcx", "memory");
+            __cpuid(0, a, b, c, d);
+            break;
+        default:
+            asm volatile("lfence\n\trdtsc\n\tlfence" : "=a"(lo), "=d"(hi) :: "memory");
+            break;
+    }
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// Store end - begin minus the calibrated overhead; no allocation, no I/O
+static inline __attribute__((always_inline)) void timing_record(timing_buffer_t *buf, uint32_t key,
+                                                                uint64_t begin, uint64_t end) {
+    if (buf->count == buf->capacity) {
+        buf->dropped++;
+        return;
+    }
+    uint64_t cycles = end - begin;
+    cycles = cycles > timing_overhead[buf->mode] ? cycles - timing_overhead[buf->mode] : 0;
+    buf->samples[buf->count++] = (timing_sample_t){key, cycles > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles};
+}
+
+static inline double timing_ns(uint64_t cycles) { return tsc_ghz > 0 ? cycles / tsc_ghz : 0; }
+
+void timing_init();
+timing_buffer_t *timing_buffer_create(const char *label, timing_mode_t mode, uint32_t capacity);
+int timing_buffer_histograms(timing_buffer_t *buf);
+void timing_buffer_release_object(const void *addr);
+void timing_flush_all();
+void timing_discard_all();
+void timing_report_all(FILE *out);
+
+#endif // TIMING_H
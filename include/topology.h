@@ -0,0 +1,51 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include "util.h"
+
+#define MAX_NODES 16            // NUMA nodes across all sockets (SNC4 x 4 sockets)
+#define MAX_NODES_PER_SOCKET 4  // SNC4
+#define MAX_CPUS 1024
+
+// Address pool locality relative to a requesting core
+typedef enum {
+    POOL_LOCAL_SNC,      // Memory of the requester's own SNC node
+    POOL_REMOTE_SNC,     // Another SNC node on the requester's socket
+    POOL_REMOTE_SOCKET   // Memory homed on a different socket
+} pool_locality_t;
+
+// One logical CPU as sysfs describes it; -1 where sysfs has nothing
+typedef struct {
+    int online;
+    int package;
+    int die;
+    int core;           // core_id, unique within the die
+    int node;
+    int l2_id;
+    int llc_id;
+    int first_sibling;  // Lowest CPU on the same physical core
+    int num_siblings;
+} cpu_topo_t;
+
+extern int num_nodes;
+extern int node_socket[MAX_NODES];                          // Package of each node, -1 if it has no CPUs
+extern int socket_nodes[MAX_SOCKETS][MAX_NODES_PER_SOCKET]; // Nodes of each socket, ascending
+extern int socket_num_nodes[MAX_SOCKETS];
+extern int cpu_node[MAX_CPUS];
+extern cpu_topo_t cpu_topo[MAX_CPUS];
+extern int num_cpus;
+
+int discover_numa_topology();
+int core_to_node(int core_id);
+int core_to_socket(int core_id);
+int select_locality_node(int core_id, pool_locality_t locality);
+const char *locality_name(pool_locality_t locality);
+void print_numa_topology();
+
+int discover_cpu_topology();
+int same_physical_core(int cpu_a, int cpu_b);
+void assign_core_roles(int primary[MAX_SOCKETS], int secondary[MAX_SOCKETS], int orchestrator[MAX_SOCKETS]);
+int socket_worker_cores(int socket_id, int *cores, int max_cores);
+void write_core_layout(FILE *fp);
+
+#endif // TOPOLOGY_H
@@ -32,12 +32,15 @@ extern int orchestrator_cores[MAX_SOCKETS];
 static inline void flush(void *p) { asm volatile("clflush 0(%0)"::"r"(p): "rax"); }
 static inline void maccess(void *p) { asm volatile("movq (%0), %%rax"::"r"(p): "rax"); }
 static inline void mmodify(void *p) { asm volatile("movq $0x1, (%0)"::"r"(p): "memory"); }
+static inline void matomic(void *p) { asm volatile("lock addq $0x1, (%0)"::"r"(p): "memory"); }
 static inline void mfence() { asm volatile("mfence"); }
 
 uint64_t rdtsc();
+uint64_t virt_to_phys(void *addr);
 
 void set_process_affinity(int core_id);
 void find_primary_secondary_cores_per_socket();
+void print_core_roles();
 void execute_on_socket_core(int socket_id, int use_secondary, void (*func)(void *), void *arg, int old_core_id);
 
 void display_progress(const char *label, int current, int total);
@@ -0,0 +1,328 @@
+#include <string.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include "actor.h"
+#include "timing.h"
+
+static actor_t *actors[MAX_ACTORS];
+static int num_actors = 0;
+
+static inline void cpu_relax() { asm volatile("pause" ::: "memory"); }
+
+// Orchestrator-side wait step; yields now and then in case an actor shares
+// its core
+static inline void backoff(int *spins) {
+    if (++*spins % ACTOR_SPIN_LIMIT == 0) {
+        sched_yield();
+    } else {
+        cpu_relax();
+    }
+}
+
+static void futex_wait(uint32_t *addr, uint32_t val) {
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static void futex_wake(uint32_t *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+// Orchestrator and actor exchange TSC stamps through this line
+typedef struct {
+    uint32_t seq __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint32_t ack;
+    uint64_t tsc;
+} tsc_probe_t;
+
+static inline void access_line(actor_op_t op, void *line) {
+    switch (op) {
+        case ACTOR_READ:
+            maccess(line);
+            break;
+        case ACTOR_WRITE:
+            mmodify(line);
+            break;
+        case ACTOR_FLUSH:
+            flush(line);
+            break;
+        case ACTOR_ATOMIC:
+            matomic(line);
+            break;
+        default:
+            break;
+    }
+}
+
+static void run_lines(const actor_cmd_t *cmd) {
+    timing_buffer_t *buf = cmd->buf;
+    for (uint32_t i = 0; i < cmd->count; i++) {
+        void *line = cmd->list ? pool_line(cmd->list, cmd->first + i)
+                   : cmd->lines ? cmd->lines[cmd->first + i] : cmd->line;
+        if (buf) {
+            uint64_t begin = timing_begin(buf->mode);
+            access_line(cmd->op, line);
+            uint64_t end = timing_end(buf->mode);
+            timing_record(buf, cmd->key + i, begin, end);
+        } else {
+            access_line(cmd->op, line);
+        }
+        mfence();
+    }
+}
+
+static void run_at(actor_t *actor, actor_group_t *group) {
+    __atomic_fetch_add(&group->arrived, 1, __ATOMIC_SEQ_CST);
+    uint64_t deadline;
+    while ((deadline = __atomic_load_n(&group->deadline, __ATOMIC_ACQUIRE)) == 0) {
+        cpu_relax();
+    }
+
+    // Tight spin on the local TSC, no pause: the release should be as sharp
+    // as the clock
+    uint64_t local = deadline + actor->tsc_offset;
+    uint64_t now;
+    while ((int64_t)((now = timing_begin(TIMING_RDTSCP)) - local) < 0) {
+    }
+    actor->start_tsc = now - actor->tsc_offset;
+}
+
+static void run_tsc_probe(tsc_probe_t *probe, uint32_t rounds) {
+    for (uint32_t r = 1; r <= rounds; r++) {
+        while (__atomic_load_n(&probe->seq, __ATOMIC_ACQUIRE) != r) {
+            cpu_relax();
+        }
+        probe->tsc = timing_begin(TIMING_RDTSCP);
+        __atomic_store_n(&probe->ack, r, __ATOMIC_RELEASE);
+    }
+}
+
+static void *actor_main(void *arg) {
+    actor_t *actor = arg;
+    uint32_t tail = actor->tail;
+
+    for (;;) {
+        uint32_t head = __atomic_load_n(&actor->head, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            // Spin briefly, then sleep so an idle actor never competes with
+            // the thread measuring on its core
+            for (int spin = 0; spin < ACTOR_SPIN_LIMIT && head == tail; spin++) {
+                cpu_relax();
+                head = __atomic_load_n(&actor->head, __ATOMIC_ACQUIRE);
+            }
+            if (head == tail) {
+                __atomic_store_n(&actor->sleeping, 1, __ATOMIC_SEQ_CST);
+                if (__atomic_load_n(&actor->head, __ATOMIC_SEQ_CST) == tail) {
+                    futex_wait(&actor->head, tail);
+                }
+                __atomic_store_n(&actor->sleeping, 0, __ATOMIC_RELAXED);
+                continue;
+            }
+        }
+
+        actor_cmd_t *cmd = &actor->ring[tail % ACTOR_RING_SIZE];
+        if (cmd->op == ACTOR_STOP) {
+            __atomic_store_n(&actor->tail, tail + 1, __ATOMIC_RELEASE);
+            return NULL;
+        }
+        if (cmd->op == ACTOR_WAIT) {
+            while ((int32_t)(__atomic_load_n(&cmd->peer->tail, __ATOMIC_ACQUIRE) - cmd->peer_done) < 0) {
+                cpu_relax();
+            }
+        } else if (cmd->op == ACTOR_AT) {
+            run_at(actor, cmd->group);
+        } else if (cmd->op == ACTOR_TSC_PROBE) {
+            run_tsc_probe(cmd->line, cmd->count);
+        } else if (cmd->op == ACTOR_CALL) {
+            cmd->fn(cmd->arg);
+        } else {
+            run_lines(cmd);
+        }
+
+        tail++;
+        __atomic_store_n(&actor->tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+// Actor pinned to core_id, started on first use
+actor_t *actor_get(int core_id) {
+    for (int i = 0; i < num_actors; i++) {
+        if (actors[i]->core_id == core_id) return actors[i];
+    }
+    if (num_actors >= MAX_ACTORS) {
+        fprintf(stderr, "Error: no actor slot left for core %d (MAX_ACTORS %d)\n", core_id, MAX_ACTORS);
+        return NULL;
+    }
+
+    actor_t *actor = aligned_alloc(CACHE_LINE_SIZE, sizeof(actor_t));
+    if (!actor) {
+        perror("aligned_alloc");
+        return NULL;
+    }
+    memset(actor, 0, sizeof(*actor));
+    actor->core_id = core_id;
+
+    pthread_attr_t attr;
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core_id, &cpuset);
+    pthread_attr_init(&attr);
+    pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+
+    int err = pthread_create(&actor->thread, &attr, actor_main, actor);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        fprintf(stderr, "Error: cannot start actor on core %d: %s\n", core_id, strerror(err));
+        free(actor);
+        return NULL;
+    }
+
+    actors[num_actors++] = actor;
+    return actor;
+}
+
+static void push(actor_t *actor, const actor_cmd_t *cmd) {
+    uint32_t head = actor->head;
+    int spins = 0;
+    while (head - __atomic_load_n(&actor->tail, __ATOMIC_ACQUIRE) >= ACTOR_RING_SIZE) {
+        backoff(&spins);  // Ring full
+    }
+
+    actor->ring[head % ACTOR_RING_SIZE] = *cmd;
+    __atomic_store_n(&actor->head, head + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&actor->sleeping, __ATOMIC_SEQ_CST)) {
+        futex_wake(&actor->head);
+    }
+}
+
+void actor_submit(actor_t *actor, actor_op_t op, const pool_list_t *list, uint32_t first, uint32_t count) {
+    if (!actor || count == 0) return;
+    actor_cmd_t cmd = {.op = op, .first = first, .count = count, .list = list};
+    push(actor, &cmd);
+}
+
+void actor_submit_lines(actor_t *actor, actor_op_t op, void *const *lines, uint32_t count) {
+    if (!actor || count == 0) return;
+    actor_cmd_t cmd = {.op = op, .count = count, .lines = lines};
+    push(actor, &cmd);
+}
+
+void actor_submit_line(actor_t *actor, actor_op_t op, void *line) {
+    if (!actor) return;
+    actor_cmd_t cmd = {.op = op, .count = 1, .line = line};
+    push(actor, &cmd);
+}
+
+void actor_submit_timed(actor_t *actor, actor_op_t op, const pool_list_t *list, uint32_t first, uint32_t count,
+                        timing_buffer_t *buf, uint32_t key) {
+    if (!actor || count == 0) return;
+    actor_cmd_t cmd = {.op = op, .first = first, .count = count, .list = list, .buf = buf, .key = key};
+    push(actor, &cmd);
+}
+
+// Run fn(arg) on the actor's core, for loops the line ops cannot express
+// (unfenced streams, rate-paced traffic)
+void actor_call(actor_t *actor, void (*fn)(void *), void *arg) {
+    if (!actor || !fn) return;
+    actor_cmd_t cmd = {.op = ACTOR_CALL, .fn = fn, .arg = arg};
+    push(actor, &cmd);
+}
+
+// Commands queued to actor from now on run only after everything already
+// queued to peer has completed
+void actor_after(actor_t *actor, actor_t *peer) {
+    if (!actor || !peer || actor == peer) return;
+    actor_cmd_t cmd = {.op = ACTOR_WAIT, .peer = peer, .peer_done = peer->head};
+    push(actor, &cmd);
+}
+
+void actor_sync(actor_t *actor) {
+    if (!actor) return;
+    int spins = 0;
+    while (__atomic_load_n(&actor->tail, __ATOMIC_ACQUIRE) != actor->head) {
+        backoff(&spins);
+    }
+}
+
+// Offset of the actor's TSC from the calling thread's, from the round trip
+// with the smallest RTT (the midpoint is then least uncertain). Measured
+// once per actor; the caller should stay on the orchestrator core.
+int64_t actor_tsc_offset(actor_t *actor) {
+    if (!actor || actor->tsc_measured) return actor ? actor->tsc_offset : 0;
+
+    static tsc_probe_t probe;
+    memset(&probe, 0, sizeof(probe));
+    actor_sync(actor);
+    actor_cmd_t cmd = {.op = ACTOR_TSC_PROBE, .count = ACTOR_TSC_ROUNDS, .line = &probe};
+    push(actor, &cmd);
+
+    uint64_t best_rtt = UINT64_MAX;
+    for (uint32_t r = 1; r <= ACTOR_TSC_ROUNDS; r++) {
+        uint64_t t0 = timing_begin(TIMING_RDTSCP);
+        __atomic_store_n(&probe.seq, r, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&probe.ack, __ATOMIC_ACQUIRE) != r) {
+            cpu_relax();
+        }
+        uint64_t t1 = timing_end(TIMING_RDTSCP);
+        if (t1 - t0 < best_rtt) {
+            best_rtt = t1 - t0;
+            actor->tsc_offset = (int64_t)(probe.tsc - (t0 + (t1 - t0) / 2));
+        }
+    }
+    actor_sync(actor);
+    actor->tsc_measured = 1;
+    DEBUG_PRINT("Actor on core %d: TSC offset %ld (RTT %lu)", actor->core_id, actor->tsc_offset, best_rtt);
+    return actor->tsc_offset;
+}
+
+void actor_group_init(actor_group_t *group) {
+    memset(group, 0, sizeof(*group));
+}
+
+// Queue the actor's arrival at the group; what is queued after it runs from
+// the deadline on. Every actor queued here must be released before it can
+// be synced.
+void actor_at(actor_t *actor, actor_group_t *group) {
+    if (!actor) return;
+    actor_tsc_offset(actor);
+    group->expected++;
+    actor_cmd_t cmd = {.op = ACTOR_AT, .group = group};
+    push(actor, &cmd);
+}
+
+// Wait for every actor to arrive, then set the deadline lead_cycles ahead
+uint64_t actor_group_release(actor_group_t *group, uint64_t lead_cycles) {
+    int spins = 0;
+    while (__atomic_load_n(&group->arrived, __ATOMIC_ACQUIRE) < (uint32_t)group->expected) {
+        backoff(&spins);
+    }
+    uint64_t deadline = timing_begin(TIMING_RDTSCP) + lead_cycles;
+    __atomic_store_n(&group->deadline, deadline, __ATOMIC_RELEASE);
+    return deadline;
+}
+
+// Baseline runs skip the ROI: release a group that never was, outside the
+// measured window, and wait for its actors to drain
+void actor_group_cancel(actor_group_t *group, actor_t *const *members, int count) {
+    if (group->deadline) return;
+    actor_group_release(group, 0);
+    for (int i = 0; i < count; i++) {
+        actor_sync(members[i]);
+    }
+}
+
+void actor_sync_all() {
+    for (int i = 0; i < num_actors; i++) {
+        actor_sync(actors[i]);
+    }
+}
+
+void actor_stop_all() {
+    for (int i = 0; i < num_actors; i++) {
+        actor_cmd_t cmd = {.op = ACTOR_STOP};
+        push(actors[i], &cmd);
+        pthread_join(actors[i]->thread, NULL);
+        free(actors[i]);
+    }
+    num_actors = 0;
+}
@@ -0,0 +1,249 @@
+#include <string.h>
+#include "addr_pool.h"
+#include "socket_memory.h"
+
+int pool_lines_per_cha = MAX_ADDRESSES;
+
+static const pool_list_t empty_list = {0};
+
+static int valid_list(const addr_pool_t *pool, int socket_id, int cha) {
+    return pool && socket_id >= 0 && socket_id < pool->num_sockets && cha >= 0 && cha < NUM_CHA;
+}
+
+static inline int offset_set(uint32_t offset) {
+    return (offset & L3_SLICE_SET_INDEX_MASK) >> 6;
+}
+
+void addr_pool_init(addr_pool_t *pool, int num_sockets) {
+    memset(pool, 0, sizeof(*pool));
+    pool->num_sockets = num_sockets > MAX_SOCKETS ? MAX_SOCKETS : num_sockets;
+    for (int s = 0; s < MAX_SOCKETS; s++) {
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            pool->lists[s][cha].node = -1;
+        }
+    }
+}
+
+void addr_pool_free(addr_pool_t *pool) {
+    for (int s = 0; s < MAX_SOCKETS; s++) {
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            free(pool->lists[s][cha].offsets);
+            free(pool->lists[s][cha].set_start);
+        }
+    }
+    addr_pool_init(pool, pool->num_sockets);
+}
+
+int addr_pool_add(addr_pool_t *pool, int socket_id, int cha, int node, uint8_t *base, void *line) {
+    if (!valid_list(pool, socket_id, cha)) {
+        fprintf(stderr, "Error: invalid pool list (socket %d, CHA %d)\n", socket_id, cha);
+        return -1;
+    }
+
+    pool_list_t *list = &pool->lists[socket_id][cha];
+    if (list->count > 0 && (list->node != node || list->base != base)) {
+        fprintf(stderr, "Error: CHA %d of socket %d already holds lines of node %d\n", cha, socket_id, list->node);
+        return -1;
+    }
+
+    uintptr_t offset = (uint8_t *)line - base;
+    if ((uint8_t *)line < base || offset > UINT32_MAX) {
+        fprintf(stderr, "Error: line %p is outside the node %d buffer\n", line, node);
+        return -1;
+    }
+
+    if (list->count == list->capacity) {
+        uint32_t capacity = list->capacity ? list->capacity * 2 : 64;
+        uint32_t *offsets = realloc(list->offsets, capacity * sizeof(uint32_t));
+        if (!offsets) {
+            perror("realloc");
+            return -1;
+        }
+        list->offsets = offsets;
+        list->capacity = capacity;
+    }
+
+    list->offsets[list->count++] = (uint32_t)offset;
+    list->base = base;
+    list->node = node;
+    pool->finalized = 0;
+    return 0;
+}
+
+// Counting sort of every list by L3 slice set, building the set index
+void addr_pool_finalize(addr_pool_t *pool) {
+    for (int s = 0; s < pool->num_sockets; s++) {
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            pool_list_t *list = &pool->lists[s][cha];
+            if (!list->set_start) {
+                list->set_start = malloc((L3_SLICE_SETS + 1) * sizeof(uint32_t));
+                if (!list->set_start) {
+                    perror("malloc");
+                    return;
+                }
+            }
+            memset(list->set_start, 0, (L3_SLICE_SETS + 1) * sizeof(uint32_t));
+            if (list->count == 0) continue;
+
+            for (uint32_t i = 0; i < list->count; i++) {
+                list->set_start[offset_set(list->offsets[i]) + 1]++;
+            }
+            for (int set = 0; set < L3_SLICE_SETS; set++) {
+                list->set_start[set + 1] += list->set_start[set];
+            }
+
+            uint32_t *sorted = malloc(list->count * sizeof(uint32_t));
+            uint32_t next[L3_SLICE_SETS];
+            if (!sorted) {
+                perror("malloc");
+                return;
+            }
+            memcpy(next, list->set_start, sizeof(next));
+            for (uint32_t i = 0; i < list->count; i++) {
+                sorted[next[offset_set(list->offsets[i])]++] = list->offsets[i];
+            }
+            memcpy(list->offsets, sorted, list->count * sizeof(uint32_t));
+            free(sorted);
+        }
+    }
+    pool->finalized = 1;
+}
+
+const pool_list_t *pool_list(const addr_pool_t *pool, int socket_id, int cha) {
+    if (!valid_list(pool, socket_id, cha)) {
+        fprintf(stderr, "Error: invalid pool list (socket %d, CHA %d)\n", socket_id, cha);
+        return &empty_list;
+    }
+    return &pool->lists[socket_id][cha];
+}
+
+uint32_t pool_count(const addr_pool_t *pool, int socket_id, int cha) {
+    return pool_list(pool, socket_id, cha)->count;
+}
+
+void *pool_addr(const addr_pool_t *pool, int socket_id, int cha, uint32_t idx) {
+    const pool_list_t *list = pool_list(pool, socket_id, cha);
+    if (idx >= list->count) {
+        fprintf(stderr, "Error: index %u out of range for socket %d, CHA %d (%u lines)\n",
+                idx, socket_id, cha, list->count);
+        return NULL;
+    }
+    return pool_line(list, idx);
+}
+
+// Number of lines of (socket, CHA) in one L3 slice set; *first receives the
+// index of the first of them
+uint32_t pool_set_range(const addr_pool_t *pool, int socket_id, int cha, int set, uint32_t *first) {
+    const pool_list_t *list = pool_list(pool, socket_id, cha);
+    if (!pool->finalized || !list->set_start || set < 0 || set >= L3_SLICE_SETS) {
+        *first = 0;
+        return 0;
+    }
+    *first = list->set_start[set];
+    return list->set_start[set + 1] - list->set_start[set];
+}
+
+// File layout: magic, version, NUM_CHA, number of sockets, L3_SLICE_SETS,
+// then per (socket, CHA): node, count, offsets[count]
+int addr_pool_save(const addr_pool_t *pool, const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        perror("Error opening pool file");
+        return -1;
+    }
+
+    uint64_t magic = POOL_FILE_MAGIC;
+    uint32_t header[4] = {POOL_FILE_VERSION, NUM_CHA, pool->num_sockets, L3_SLICE_SETS};
+    fwrite(&magic, sizeof(magic), 1, fp);
+    fwrite(header, sizeof(header), 1, fp);
+
+    for (int s = 0; s < pool->num_sockets; s++) {
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            const pool_list_t *list = &pool->lists[s][cha];
+            int32_t node = list->node;
+            fwrite(&node, sizeof(node), 1, fp);
+            fwrite(&list->count, sizeof(list->count), 1, fp);
+            fwrite(list->offsets, sizeof(uint32_t), list->count, fp);
+        }
+    }
+
+    int err = ferror(fp);
+    fclose(fp);
+    if (err) {
+        fprintf(stderr, "Error: failed to write %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Load a pool saved by addr_pool_save and rebase it on this run's node buffers
+int addr_pool_load(addr_pool_t *pool, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return -1;
+    }
+
+    uint64_t magic;
+    uint32_t header[4];
+    if (fread(&magic, sizeof(magic), 1, fp) != 1 || fread(header, sizeof(header), 1, fp) != 1 ||
+        magic != POOL_FILE_MAGIC || header[0] != POOL_FILE_VERSION || header[1] != NUM_CHA ||
+        header[2] == 0 || header[2] > MAX_SOCKETS || header[3] != L3_SLICE_SETS) {
+        fprintf(stderr, "Error: %s is not a compatible pool file\n", path);
+        fclose(fp);
+        return -1;
+    }
+
+    addr_pool_free(pool);
+    addr_pool_init(pool, header[2]);
+
+    for (int s = 0; s < pool->num_sockets; s++) {
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            pool_list_t *list = &pool->lists[s][cha];
+            int32_t node;
+            uint32_t count;
+            if (fread(&node, sizeof(node), 1, fp) != 1 || fread(&count, sizeof(count), 1, fp) != 1) {
+                goto truncated;
+            }
+            if (count == 0) continue;  // CHA absent on this part
+            if (count < (uint32_t)pool_lines_per_cha) {
+                fprintf(stderr, "Error: %s holds %u lines for socket %d, CHA %d, fewer than the %d asked for\n",
+                        path, count, s, cha, pool_lines_per_cha);
+                goto fail;
+            }
+            if (node < 0 || node >= MAX_NODES || !node_buffers[node]) {
+                fprintf(stderr, "Error: %s refers to node %d, which has no buffer\n", path, node);
+                goto fail;
+            }
+
+            list->offsets = malloc(count * sizeof(uint32_t));
+            if (!list->offsets) {
+                perror("malloc");
+                goto fail;
+            }
+            if (fread(list->offsets, sizeof(uint32_t), count, fp) != count) {
+                goto truncated;
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                if (list->offsets[i] > BUFFER_SIZE - CACHE_LINE_SIZE) {
+                    fprintf(stderr, "Error: %s has offset 0x%x past the %ld-byte buffer\n", path,
+                            list->offsets[i], BUFFER_SIZE);
+                    goto fail;
+                }
+            }
+            list->count = list->capacity = count;
+            list->node = node;
+            list->base = node_buffers[node];
+        }
+    }
+
+    fclose(fp);
+    addr_pool_finalize(pool);
+    return 0;
+
+truncated:
+    fprintf(stderr, "Error: %s is truncated\n", path);
+fail:
+    fclose(fp);
+    addr_pool_free(pool);
+    return -1;
+}
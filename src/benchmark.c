@@ -1,15 +1,30 @@
 #include "benchmark.h"
+#include "pattern.h"
+#include "timing.h"
+#include "topology.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <dirent.h>
 #include <dlfcn.h>
+#include <unistd.h>
 
 #define BENCHMARK_DIR "bin/"
 #define MAX_BENCHMARKS 100
 #define MAX_PATH_LEN 512
 
-Benchmark *benchmarks[MAX_BENCHMARKS];
+// Loaded benchmark. v1 plugins and pattern specs run through a v2 table
+// whose callbacks forward to the v1 ones; v2 is first so a bench_ctx_t's
+// benchmark pointer leads back to the entry.
+typedef struct {
+    BenchmarkV2 v2;
+    const Benchmark *v1;
+    const char *pattern_spec;   // Spec path of pattern-backed benchmarks, else NULL
+    const char *source;         // File the benchmark was loaded from
+    void *handle;               // dlopen handle of plugins
+} bench_entry_t;
+
+static bench_entry_t benchmarks[MAX_BENCHMARKS];
 int num_benchmarks = 0;
 void* global_address_list = NULL;
 int* global_primary_cores = NULL;
@@ -24,17 +39,155 @@ void set_global_values(void* address_list, int* primary, int* secondary, int* or
     global_orchestrator_cores = orchestrator;
 }
 
+static const Benchmark *legacy(bench_ctx_t *ctx) {
+    return ((const bench_entry_t *)ctx->benchmark)->v1;
+}
+
+// v1 plugins were built against the fixed address list; they get the first
+// MAX_ADDRESSES lines of each pool list in that layout, NULL past the end.
+// Pattern specs run in-process and take the pool itself.
+static void *legacy_address_list[MAX_SOCKETS][NUM_CHA][MAX_ADDRESSES];
+
+static void *v1_addr_list(bench_ctx_t *ctx) {
+    return ((const bench_entry_t *)ctx->benchmark)->pattern_spec ? (void *)ctx->pool : legacy_address_list;
+}
+
+// Rebuilt before every run, outside the ROI, so it follows a reloaded pool
+static void fill_legacy_address_list(const addr_pool_t *pool) {
+    for (int socket = 0; socket < MAX_SOCKETS; socket++) {
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            const pool_list_t *list = socket < pool->num_sockets ? pool_list(pool, socket, cha) : NULL;
+            for (uint32_t idx = 0; idx < MAX_ADDRESSES; idx++) {
+                legacy_address_list[socket][cha][idx] = list && idx < list->count ? pool_line(list, idx) : NULL;
+            }
+        }
+    }
+}
+
+static void v1_init(bench_ctx_t *ctx) {
+    if (!((const bench_entry_t *)ctx->benchmark)->pattern_spec) fill_legacy_address_list(ctx->pool);
+    legacy(ctx)->init(v1_addr_list(ctx), ctx->primary_cores, ctx->secondary_cores, ctx->orchestrator_cores);
+}
+
+static void v1_roi(bench_ctx_t *ctx) {
+    legacy(ctx)->roi(v1_addr_list(ctx), ctx->primary_cores, ctx->secondary_cores, ctx->orchestrator_cores);
+}
+
+static void v1_cleanup(bench_ctx_t *ctx) {
+    if (legacy(ctx)->cleanup) {
+        legacy(ctx)->cleanup(v1_addr_list(ctx), ctx->primary_cores, ctx->secondary_cores, ctx->orchestrator_cores);
+    }
+}
+
+static bench_entry_t v1_entry(const Benchmark *benchmark, const char *pattern_spec) {
+    return (bench_entry_t){
+        {BENCHMARK_ABI_VERSION, benchmark->name, NULL, v1_init, v1_roi, v1_cleanup, NULL},
+        benchmark, pattern_spec, pattern_spec, NULL};
+}
+
 // Check if a benchmark with the same name already exists
 int is_duplicate(const char *name) {
     for (int i = 0; i < num_benchmarks; i++) {
-        if (strcmp(benchmarks[i]->name, name) == 0) {
+        if (strcmp(benchmarks[i].v2.name, name) == 0) {
             return 1;  // Duplicate found
         }
     }
     return 0;
 }
 
-// Function to dynamically load benchmarks from shared object files (*.so)
+// Whether a file is already behind one of the benchmarks
+static int is_loaded(const char *source) {
+    for (int i = 0; i < num_benchmarks; i++) {
+        if (benchmarks[i].source && strcmp(benchmarks[i].source, source) == 0) return 1;
+    }
+    return 0;
+}
+
+// Register every spec in PATTERN_DIR as a benchmark run by the pattern engine.
+// Specs are only parsed fully once selected.
+static void load_patterns() {
+    DIR *dir = opendir(PATTERN_DIR);
+    if (!dir) return;  // Pattern specs are optional
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && num_benchmarks < MAX_BENCHMARKS) {
+        if (!strstr(entry->d_name, ".json")) continue;
+
+        char spec_path[MAX_PATH_LEN];
+        char name[64];
+        snprintf(spec_path, sizeof(spec_path), "%s%s", PATTERN_DIR, entry->d_name);
+        if (is_loaded(spec_path)) continue;
+        if (pattern_spec_name(spec_path, name, sizeof(name)) != 0) {
+            fprintf(stderr, "Failed to read pattern name from %s\n", spec_path);
+            continue;
+        }
+
+        if (is_duplicate(name)) {
+            fprintf(stderr, "Error: Duplicate benchmark name '%s' found in %s\n", name, spec_path);
+            continue;
+        }
+
+        Benchmark *benchmark = malloc(sizeof(Benchmark));
+        if (!benchmark) {
+            perror("malloc");
+            break;
+        }
+        benchmark->name = strdup(name);
+        benchmark->init = pattern_init;
+        benchmark->roi = pattern_roi;
+        benchmark->cleanup = pattern_cleanup;
+
+        benchmarks[num_benchmarks++] = v1_entry(benchmark, strdup(spec_path));
+    }
+
+    closedir(dir);
+}
+
+// dlopen a plugin into *entry
+static int open_plugin(const char *so_path, bench_entry_t *entry) {
+    void *handle = dlopen(so_path, RTLD_NOW);
+    if (!handle) {
+        fprintf(stderr, "Failed to load %s: %s\n", so_path, dlerror());
+        return -1;
+    }
+
+    BenchmarkV2 *benchmark_v2 = (BenchmarkV2 *) dlsym(handle, "benchmark_v2");
+    Benchmark *benchmark = benchmark_v2 ? NULL : (Benchmark *) dlsym(handle, "benchmark");
+    if (!benchmark_v2 && !benchmark) {
+        fprintf(stderr, "Failed to find 'benchmark_v2' or 'benchmark' symbol in %s\n", so_path);
+        dlclose(handle);
+        return -1;
+    }
+
+    if (benchmark_v2 && benchmark_v2->abi_version != BENCHMARK_ABI_VERSION) {
+        fprintf(stderr, "Error: %s was built for ABI version %d, expected %d\n", so_path,
+                benchmark_v2->abi_version, BENCHMARK_ABI_VERSION);
+        dlclose(handle);
+        return -1;
+    }
+
+    if (benchmark_v2) {
+        *entry = (bench_entry_t){*benchmark_v2, NULL, NULL, NULL, NULL};
+    } else {
+        *entry = v1_entry(benchmark, NULL);
+    }
+    entry->source = strdup(so_path);
+    entry->handle = handle;
+    return 0;
+}
+
+// Unmap a plugin, dropping the timing buffers it created first: their
+// labels' owners and flush callbacks go with it
+static void close_plugin(void *handle) {
+    void *symbol = dlsym(handle, "benchmark_v2");
+    if (!symbol) symbol = dlsym(handle, "benchmark");
+    if (symbol) timing_buffer_release_object(symbol);
+    dlclose(handle);
+}
+
+// Function to dynamically load benchmarks from shared object files (*.so).
+// Files loaded by an earlier call are skipped, so calling it again picks up
+// new plugins and specs only.
 void load_benchmarks() {
     DIR *dir = opendir(BENCHMARK_DIR);
     if (!dir) {
@@ -43,53 +196,289 @@ void load_benchmarks() {
     }
 
     struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
+    while ((entry = readdir(dir)) != NULL && num_benchmarks < MAX_BENCHMARKS) {
         if (!strstr(entry->d_name, ".so")) continue;
 
         char so_path[MAX_PATH_LEN];
         snprintf(so_path, sizeof(so_path), "%s%s", BENCHMARK_DIR, entry->d_name);
+        if (is_loaded(so_path)) continue;
 
-        void *handle = dlopen(so_path, RTLD_NOW);
-        if (!handle) {
-            fprintf(stderr, "Failed to load %s: %s\n", so_path, dlerror());
-            continue;
-        }
+        bench_entry_t loaded;
+        if (open_plugin(so_path, &loaded) != 0) continue;
 
-        Benchmark *benchmark = (Benchmark *) dlsym(handle, "benchmark");
-        if (!benchmark) {
-            fprintf(stderr, "Failed to find 'benchmark' symbol in %s\n", so_path);
-            dlclose(handle);
+        if (is_duplicate(loaded.v2.name)) {
+            fprintf(stderr, "Error: Duplicate benchmark name '%s' found in %s\n", loaded.v2.name, so_path);
+            close_plugin(loaded.handle);
+            free((char *)loaded.source);
             continue;
         }
+        benchmarks[num_benchmarks++] = loaded;
+    }
 
-        if (is_duplicate(benchmark->name)) {
-            fprintf(stderr, "Error: Duplicate benchmark name '%s' found in %s\n", benchmark->name, so_path);
-            dlclose(handle);
-            continue;
+    closedir(dir);
+    load_patterns();
+}
+
+// Load only what it takes to find one benchmark: bin/<name>.so first, then
+// the pattern specs, and every plugin only if neither has it
+const BenchmarkV2 *load_benchmark(const char *name) {
+    if (!is_duplicate(name)) {
+        char so_path[MAX_PATH_LEN];
+        bench_entry_t loaded;
+        snprintf(so_path, sizeof(so_path), "%s%s.so", BENCHMARK_DIR, name);
+        if (!is_loaded(so_path) && access(so_path, R_OK) == 0 && num_benchmarks < MAX_BENCHMARKS &&
+            open_plugin(so_path, &loaded) == 0) {
+            if (is_duplicate(loaded.v2.name)) {
+                close_plugin(loaded.handle);
+                free((char *)loaded.source);
+            } else {
+                benchmarks[num_benchmarks++] = loaded;
+            }
         }
+    }
+    if (!is_duplicate(name)) load_patterns();
+    if (!is_duplicate(name)) load_benchmarks();
+    return get_benchmark_by_name(name);
+}
 
-        benchmarks[num_benchmarks++] = benchmark;
+// Callbacks of a plugin whose reload failed: the entry keeps its slot, so
+// BenchmarkV2 pointers held elsewhere stay valid, but every set is refused
+static int unloaded_setup(bench_ctx_t *ctx) {
+    fprintf(stderr, "Error: %s is not loaded; fix and reload it\n", ((const BenchmarkV2 *)ctx->benchmark)->name);
+    return -1;
+}
 
-        if (num_benchmarks >= MAX_BENCHMARKS) break;
+static void unloaded_run(bench_ctx_t *ctx) {
+}
+
+// Reopen a plugin from its (possibly rebuilt) shared object; an unknown name
+// rescans for new plugins and specs. Pattern specs are re-read whenever they
+// are selected anyway.
+int reload_benchmark(const char *name) {
+    int i = 0;
+    while (i < num_benchmarks && strcmp(benchmarks[i].v2.name, name) != 0) i++;
+    if (i == num_benchmarks) {
+        load_benchmarks();
+        return is_duplicate(name) ? 0 : -1;
     }
+    bench_entry_t *entry = &benchmarks[i];
+    if (entry->pattern_spec) return 0;
 
-    closedir(dir);
+    // The old code must be unmapped first, or dlopen hands back the same image.
+    // An unloaded entry's name is its own copy; a loaded one's goes with the image.
+    char *unloaded_name = entry->handle ? strdup(name) : (char *)entry->v2.name;
+    const char *so_path = entry->source;
+    if (entry->handle) close_plugin(entry->handle);
+    if (open_plugin(so_path, entry) != 0) {
+        fprintf(stderr, "Error: %s unloaded, %s no longer loads\n", unloaded_name, so_path);
+        entry->v2 = (BenchmarkV2){BENCHMARK_ABI_VERSION, unloaded_name, unloaded_setup, unloaded_run,
+                                  unloaded_run, unloaded_run, NULL};
+        entry->v1 = NULL;
+        entry->handle = NULL;
+        return -1;
+    }
+    free(unloaded_name);
+    free((char *)so_path);
+    printf("Reloaded %s from %s\n", entry->v2.name, entry->source);
+    return 0;
 }
 
 // Get a benchmark by name
-Benchmark* get_benchmark_by_name(const char *name) {
+const BenchmarkV2* get_benchmark_by_name(const char *name) {
     for (int i = 0; i < num_benchmarks; i++) {
-        if (strcmp(benchmarks[i]->name, name) == 0) {
-            return benchmarks[i];
+        if (strcmp(benchmarks[i].v2.name, name) == 0) {
+            if (benchmarks[i].pattern_spec && pattern_load(benchmarks[i].pattern_spec) != 0) return NULL;
+            return &benchmarks[i].v2;
         }
     }
     return NULL;
 }
 
+// Shared object or pattern spec behind a benchmark
+const char *benchmark_source(const BenchmarkV2 *benchmark) {
+    return ((const bench_entry_t *)benchmark)->source;
+}
+
+const BenchmarkV2 *benchmark_at(int index) {
+    return index >= 0 && index < num_benchmarks ? &benchmarks[index].v2 : NULL;
+}
+
 // List all available benchmarks
 void list_available_benchmarks() {
     printf("Available Benchmarks:\n");
     for (int i = 0; i < num_benchmarks; i++) {
-        printf("  - %s\n", benchmarks[i]->name);
+        const bench_entry_t *entry = &benchmarks[i];
+        printf("  - %s%s\n", entry->v2.name,
+               entry->v1 ? "" : !entry->handle ? " (unloaded)" : " (v2)");
+    }
+}
+
+void bench_ctx_init(bench_ctx_t *ctx, const BenchmarkV2 *benchmark, addr_pool_t *pool, int num_sockets) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->abi_version = BENCHMARK_ABI_VERSION;
+    ctx->benchmark = benchmark;
+    ctx->num_sockets = num_sockets;
+    ctx->num_chas = NUM_CHA;
+    ctx->pool = pool;
+    ctx->primary_cores = primary_cores;
+    ctx->secondary_cores = secondary_cores;
+    ctx->orchestrator_cores = orchestrator_cores;
+    ctx->mark_phase = bench_mark_phase;
+}
+
+int bench_param_set(bench_ctx_t *ctx, const char *key, const char *value) {
+    bench_param_t *param = NULL;
+    for (int i = 0; i < ctx->num_params && !param; i++) {
+        if (strcmp(ctx->params[i].key, key) == 0) param = &ctx->params[i];
+    }
+    if (!param) {
+        if (ctx->num_params >= MAX_BENCH_PARAMS) {
+            fprintf(stderr, "Error: more than %d benchmark parameters\n", MAX_BENCH_PARAMS);
+            return -1;
+        }
+        param = &ctx->params[ctx->num_params++];
+        snprintf(param->key, sizeof(param->key), "%s", key);
+    }
+    snprintf(param->value, sizeof(param->value), "%s", value);
+    return 0;
+}
+
+// Set a parameter from "key=value"
+int bench_param_parse(bench_ctx_t *ctx, const char *assignment) {
+    const char *eq = strchr(assignment, '=');
+    if (!eq || eq == assignment) return -1;
+
+    char key[sizeof(ctx->params[0].key)];
+    snprintf(key, sizeof(key), "%.*s", (int)(eq - assignment), assignment);
+    return bench_param_set(ctx, key, eq + 1);
+}
+
+const char *bench_param(const bench_ctx_t *ctx, const char *key, const char *fallback) {
+    for (int i = 0; i < ctx->num_params; i++) {
+        if (strcmp(ctx->params[i].key, key) == 0) return ctx->params[i].value;
+    }
+    return fallback;
+}
+
+long bench_param_long(const bench_ctx_t *ctx, const char *key, long fallback) {
+    const char *value = bench_param(ctx, key, NULL);
+    if (!value) return fallback;
+
+    char *end;
+    long parsed = strtol(value, &end, 0);
+    if (end == value || *end != '\0') {
+        fprintf(stderr, "Warning: parameter %s=%s is not a number, using %ld\n", key, value, fallback);
+        return fallback;
+    }
+    return parsed;
+}
+
+// Socket parameter. A socket id given explicitly must exist; only the
+// built-in default, written for four sockets, is folded onto the pool's.
+// Returns -1 for a socket the machine does not have.
+int bench_param_socket(const bench_ctx_t *ctx, const char *key, int fallback) {
+    if (!bench_param(ctx, key, NULL)) return pool_socket(ctx->pool, fallback);
+
+    long socket_id = bench_param_long(ctx, key, -1);
+    if (socket_id < 0 || socket_id >= ctx->pool->num_sockets) {
+        fprintf(stderr, "Error: parameter %s=%ld, but there are %d sockets\n", key, socket_id,
+                ctx->pool->num_sockets);
+        return -1;
+    }
+    return socket_id;
+}
+
+// Helper cores of a benchmark: the colon-separated list of parameter key
+// (e.g. cores=4:6:8), else the first wanted worker cores of socket_id. Cores
+// on the physical core of exclude_core are left out either way. Returns how
+// many were picked, -1 when the socket has fewer than wanted.
+int bench_param_cores(const bench_ctx_t *ctx, const char *key, int socket_id, int wanted, int exclude_core,
+                      int *cores, int max_cores) {
+    const char *list = bench_param(ctx, key, NULL);
+    int count = 0;
+    if (list) {
+        char *end;
+        for (const char *p = list; *p && count < max_cores; p = end + 1) {
+            int core = strtol(p, &end, 10);
+            if (end == p) {
+                fprintf(stderr, "Warning: parameter %s=%s is not a core list\n", key, list);
+                break;
+            }
+            if (same_physical_core(core, exclude_core)) {
+                fprintf(stderr, "Warning: core %d shares a physical core with core %d, skipped\n", core,
+                        exclude_core);
+            } else {
+                cores[count++] = core;
+            }
+            if (*end != ':') break;
+        }
+        return count;
+    }
+
+    int candidates[MAX_ACTORS];
+    int num_candidates = socket_worker_cores(socket_id, candidates, MAX_ACTORS);
+    for (int i = 0; i < num_candidates && count < wanted && count < max_cores; i++) {
+        if (!same_physical_core(candidates[i], exclude_core)) cores[count++] = candidates[i];
+    }
+    return count == wanted ? count : -1;
+}
+
+// 0..n-1 in a random order (xorshift64 from seed, Fisher-Yates), malloc'ed;
+// the same seed gives the same order
+uint32_t *bench_shuffled_order(uint32_t n, uint64_t seed) {
+    uint32_t *order = malloc((n ? n : 1) * sizeof(uint32_t));
+    if (!order) return NULL;
+    for (uint32_t i = 0; i < n; i++) order[i] = i;
+
+    uint64_t s = seed ? seed : 1;
+    for (uint32_t i = n ? n - 1 : 0; i > 0; i--) {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        uint32_t j = s % (i + 1);
+        uint32_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    return order;
+}
+
+// Actor on the primary (or secondary) core of a socket
+actor_t *bench_actor(bench_ctx_t *ctx, int socket_id, int secondary) {
+    socket_id = pool_socket(ctx->pool, socket_id);
+    actor_t **slot = secondary ? &ctx->secondary_actors[socket_id] : &ctx->primary_actors[socket_id];
+    if (!*slot) {
+        *slot = actor_get(secondary ? ctx->secondary_cores[socket_id] : ctx->primary_cores[socket_id]);
+    }
+    return *slot;
+}
+
+void bench_report(bench_ctx_t *ctx, const char *name, double value, const char *unit) {
+    bench_metric_t *metric = NULL;
+    for (int i = 0; i < ctx->num_metrics && !metric; i++) {
+        if (strcmp(ctx->metrics[i].name, name) == 0) metric = &ctx->metrics[i];
+    }
+    if (!metric) {
+        if (ctx->num_metrics >= MAX_BENCH_METRICS) return;
+        metric = &ctx->metrics[ctx->num_metrics++];
+        snprintf(metric->name, sizeof(metric->name), "%s", name);
+        snprintf(metric->unit, sizeof(metric->unit), "%s", unit ? unit : "");
+        metric->min = value;
+        metric->max = value;
+    }
+    metric->sum += value;
+    metric->samples++;
+    if (value < metric->min) metric->min = value;
+    if (value > metric->max) metric->max = value;
+}
+
+// Print and reset the metrics reported since the last call
+void bench_print_metrics(bench_ctx_t *ctx) {
+    for (int i = 0; i < ctx->num_metrics; i++) {
+        bench_metric_t *metric = &ctx->metrics[i];
+        printf("%s: %s: mean %.2f, min %.2f, max %.2f %s (%lu samples)\n",
+               ((const BenchmarkV2 *)ctx->benchmark)->name, metric->name, metric->sum / metric->samples,
+               metric->min, metric->max, metric->unit, metric->samples);
     }
+    ctx->num_metrics = 0;
 }
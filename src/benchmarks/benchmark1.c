@@ -4,6 +4,8 @@
 #include "socket_memory.h"
 #include "benchmark.h"
 #include "util.h"
+#include "actor.h"
+#include "timing.h"
 
 #define CONCAT(a, b) a##b
 #define STRINGIFY(x) #x
@@ -11,85 +13,109 @@
 
 // Access S3 memory: S1 read -> S2 read -> S0 read+check
 
-void CONCAT(BENCH_NAME, _init)(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
-    void* (*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+static timing_buffer_t* samples = NULL;
+
+// Runs after the counters are frozen
+static void print_samples(timing_buffer_t* buf) {
+    for (uint32_t i = 0; i < buf->count; i++) {
+        uint32_t key = buf->samples[i].key;
+        printf("CHA %u, Addr %u: %u\n", TIMING_KEY_CHA(key), TIMING_KEY_IDX(key), buf->samples[i].cycles);
+    }
+}
+
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
+    addr_pool_t* pool = ctx->pool;
+
+    if (!samples) {
+        samples = timing_buffer_create("benchmark1", TIMING_LFENCE, NUM_CHA * pool_lines_per_cha);
+        if (samples) samples->flush = print_samples;
+    }
 
     for (int cha = 0; cha < NUM_CHA; cha++) {
-        for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-            void* target = address_list[3][cha][addr];
+        const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+        for (uint32_t addr = 0; addr < list->count; addr++) {
+            void* target = pool_line(list, addr);
             flush(target);
             mfence();
         }
     }
 
-    set_process_affinity(primary_cores[1]);
+    actor_t* reader = actor_get(ctx->primary_cores[pool_socket(pool, 1)]);
     for (int cha = 0; cha < NUM_CHA; cha++) {
-        for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-            void* target = address_list[1][cha][addr];
-            maccess(target);
-            mfence();
-        }
+        const pool_list_t* list = pool_list(pool, pool_socket(pool, 1), cha);
+        actor_submit(reader, ACTOR_READ, list, 0, list->count);
     }
+    actor_sync(reader);
 
-    // set_process_affinity(primary_cores[2]);
+    // set_process_affinity(ctx->primary_cores[pool_socket(pool, 2)]);
     // for (int cha = 0; cha < NUM_CHA; cha++) {
-    //     for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    //         void* target = address_list[3][cha][addr];
+    //     const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+    //     for (uint32_t addr = 0; addr < list->count; addr++) {
+    //         void* target = pool_line(list, addr);
     //         maccess(target);
     //         mfence();
     //     }
     // }
 
-    // set_process_affinity(primary_cores[3]);
+    // set_process_affinity(ctx->primary_cores[pool_socket(pool, 3)]);
     // for (int cha = 0; cha < NUM_CHA; cha++) {
-    //     for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    //         void* target = address_list[3][cha][addr];
+    //     const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+    //     for (uint32_t addr = 0; addr < list->count; addr++) {
+    //         void* target = pool_line(list, addr);
     //         maccess(target);
     //         mfence();
     //     }
     // }
 
-    set_process_affinity(primary_cores[0]);
+    set_process_affinity(ctx->primary_cores[0]);
     for (int cha = 0; cha < NUM_CHA; cha++) {
-        for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-            void* target = address_list[3][cha][addr];
+        const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+        for (uint32_t addr = 0; addr < list->count; addr++) {
+            void* target = pool_line(list, addr);
             mfence();
         }
     }
 }
 
-void CONCAT(BENCH_NAME, _roi)(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
-    void* (*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
+    addr_pool_t* pool = ctx->pool;
+
+    if (!samples) return;
 
-    set_process_affinity(primary_cores[0]);
+    set_process_affinity(ctx->primary_cores[0]);
     uint64_t start, end;
     for (int cha = 0; cha < NUM_CHA; cha++) {
-        for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-            void* target = address_list[1][cha][addr];
-            start = rdtsc();
+        const pool_list_t* list = pool_list(pool, pool_socket(pool, 1), cha);
+        for (uint32_t addr = 0; addr < list->count; addr++) {
+            void* target = pool_line(list, addr);
+            start = timing_begin(TIMING_LFENCE);
             maccess(target);
             mfence();
-            end = rdtsc();
-            printf("CHA %d, Addr %d: %lu\n", cha, addr, end - start);
+            end = timing_end(TIMING_LFENCE);
+            timing_record(samples, TIMING_KEY(0, 1, cha, addr), start, end);
         }
     }
 }
 
-void CONCAT(BENCH_NAME, _cleanup)(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
-    void* (*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
+    addr_pool_t* pool = ctx->pool;
 
     for (int cha = 0; cha < NUM_CHA; cha++) {
-        for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-            void* target = address_list[3][cha][addr];
+        const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+        for (uint32_t addr = 0; addr < list->count; addr++) {
+            void* target = pool_line(list, addr);
             flush(target);
             mfence();
         }
     }
 }
 
-Benchmark benchmark = {
+BenchmarkV2 benchmark_v2 = {
+    BENCHMARK_ABI_VERSION,
     EXPAND_AND_STRINGIFY(BENCH_NAME),
+    NULL,
     CONCAT(BENCH_NAME, _init),
     CONCAT(BENCH_NAME, _roi),
-    CONCAT(BENCH_NAME, _cleanup)
+    CONCAT(BENCH_NAME, _cleanup),
+    NULL
 };
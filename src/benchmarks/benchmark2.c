@@ -4,6 +4,8 @@
 #include "benchmark.h"
 #include "socket_memory.h"
 #include "util.h"
+#include "actor.h"
+#include "jit.h"
 
 #define CONCAT(a, b) a##b
 #define STRINGIFY(x) #x
@@ -12,72 +14,76 @@
 // Access S3 memory: S1 read -> S2 read -> S0 read+check
 // difference from benchmark1, targets specific CHA (CHA 13)
 
+// ROI kernel: the reads of the ROI as straight-line code
+static jit_kernel_t* roi_kernel = NULL;
+
 #define cha 13
 
-void CONCAT(BENCH_NAME, _init)(void* addr_list,
-                               int* primary_cores,
-                               int* secondary_cores,
-                               int* orchestrator_cores) {
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
   printf("%s: Initialization\n", EXPAND_AND_STRINGIFY(BENCH_NAME));
 
-  void*(*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+  addr_pool_t* pool = ctx->pool;
 
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
+  const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+  for (uint32_t addr = 0; addr < list->count; addr++) {
+    void* target = pool_line(list, addr);
     flush(target);
     mfence();
   }
 
-  set_process_affinity(primary_cores[1]);
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
-    maccess(target);
-    mfence();
-  }
-  set_process_affinity(primary_cores[2]);
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
-    maccess(target);
+  actor_t* first = actor_get(ctx->primary_cores[pool_socket(pool, 1)]);
+  actor_t* second = actor_get(ctx->primary_cores[pool_socket(pool, 2)]);
+  actor_submit(first, ACTOR_READ, list, 0, list->count);
+  actor_after(second, first);
+  actor_submit(second, ACTOR_READ, list, 0, list->count);
+  actor_sync(second);
+  set_process_affinity(ctx->primary_cores[0]);
+  for (uint32_t addr = 0; addr < list->count; addr++) {
+    void* target = pool_line(list, addr);
     mfence();
   }
-  set_process_affinity(primary_cores[0]);
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
-    mfence();
+
+  if (!roi_kernel && list->count > 0) {
+    void* lines[list->count];
+    for (uint32_t addr = 0; addr < list->count; addr++) {
+      lines[addr] = pool_line(list, addr);
+    }
+    roi_kernel = jit_build(lines, NULL, ACTOR_READ, list->count, JIT_MFENCE);
   }
 }
 
-void CONCAT(BENCH_NAME, _roi)(void* addr_list,
-                              int* primary_cores,
-                              int* secondary_cores,
-                              int* orchestrator_cores) {
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
   printf("%s: Running Region of Interest\n", EXPAND_AND_STRINGIFY(BENCH_NAME));
 
-  void*(*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+  addr_pool_t* pool = ctx->pool;
+
+  // set_process_affinity(ctx->primary_cores[pool_socket(pool, 3)]);
+  if (roi_kernel) {
+    jit_run(roi_kernel);
+    return;
+  }
 
-  // set_process_affinity(primary_cores[3]);
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
+  const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+  for (uint32_t addr = 0; addr < list->count; addr++) {
+    void* target = pool_line(list, addr);
     maccess(target);
     mfence();
   }
 }
 
-void CONCAT(BENCH_NAME, _cleanup)(void* addr_list,
-                                  int* primary_cores,
-                                  int* secondary_cores,
-                                  int* orchestrator_cores) {
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
   printf("%s: Cleanup\n", EXPAND_AND_STRINGIFY(BENCH_NAME));
 
-  void*(*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+  addr_pool_t* pool = ctx->pool;
 
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
+  const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+  for (uint32_t addr = 0; addr < list->count; addr++) {
+    void* target = pool_line(list, addr);
     flush(target);
     mfence();
   }
 }
 
-Benchmark benchmark = {EXPAND_AND_STRINGIFY(BENCH_NAME),
-                       CONCAT(BENCH_NAME, _init), CONCAT(BENCH_NAME, _roi),
-                       CONCAT(BENCH_NAME, _cleanup)};
+BenchmarkV2 benchmark_v2 = {BENCHMARK_ABI_VERSION, EXPAND_AND_STRINGIFY(BENCH_NAME), NULL,
+                            CONCAT(BENCH_NAME, _init), CONCAT(BENCH_NAME, _roi),
+                            CONCAT(BENCH_NAME, _cleanup), NULL};
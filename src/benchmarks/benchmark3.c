@@ -1,89 +1,108 @@
 #define BENCH_NAME benchmark3
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "benchmark.h"
 #include "socket_memory.h"
 #include "util.h"
+#include "actor.h"
+#include "jit.h"
+#include "timing.h"
 
 #define CONCAT(a, b) a##b
 #define STRINGIFY(x) #x
 #define EXPAND_AND_STRINGIFY(x) STRINGIFY(x)
 
 // Access S3 memory: S1 read -> S2 read -> S0 read+check
-// difference from benchmark1, targets specific CHA (CHA 13)
+// difference from benchmark1, targets a single CHA
+//
+// Parameters: cha (default 1), home socket of the lines (default 3).
+// --sweep cha=0:39 covers every CHA in one process.
+
+typedef struct {
+  int cha;
+  const pool_list_t* list;
+  jit_kernel_t* roi_kernel;  // The reads of the ROI as straight-line code
+} state_t;
+
+static state_t state;
+
+int CONCAT(BENCH_NAME, _setup)(bench_ctx_t* ctx) {
+  state.cha = bench_param_long(ctx, "cha", 1);
+  if (state.cha < 0 || state.cha >= ctx->num_chas) {
+    fprintf(stderr, "%s: no CHA %d\n", EXPAND_AND_STRINGIFY(BENCH_NAME), state.cha);
+    return -1;
+  }
 
-#define cha 1
+  int home = bench_param_socket(ctx, "home", 3);
+  if (home < 0) return -1;
+  state.list = pool_list(ctx->pool, home, state.cha);
+  if (!state.list || state.list->count == 0) return -1;
 
-void CONCAT(BENCH_NAME, _init)(void* addr_list,
-                               int* primary_cores,
-                               int* secondary_cores,
-                               int* orchestrator_cores) {
-//   printf("%s: Initialization\n", EXPAND_AND_STRINGIFY(BENCH_NAME));
+  // The kernel embeds the addresses; the list is only needed to build it
+  void** lines = malloc(state.list->count * sizeof(void*));
+  if (!lines) return -1;
+  for (uint32_t addr = 0; addr < state.list->count; addr++) {
+    lines[addr] = pool_line(state.list, addr);
+  }
+  state.roi_kernel = jit_build(lines, NULL, ACTOR_READ, state.list->count, JIT_MFENCE);
+  free(lines);
 
-  void*(*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+  ctx->priv = &state;
+  return state.roi_kernel ? 0 : -1;
+}
 
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  const pool_list_t* list = st->list;
+
+  for (uint32_t addr = 0; addr < list->count; addr++) {
+    void* target = pool_line(list, addr);
     flush(target);
     mfence();
   }
 
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
-    set_process_affinity(primary_cores[1]);
-    maccess(target);
-    mfence();
-
-    set_process_affinity(primary_cores[2]);
-    maccess(target);
-    mfence();
+  // Ping-pong each line between the two cores
+  actor_t* first = bench_actor(ctx, 1, 0);
+  actor_t* second = bench_actor(ctx, 2, 0);
+  for (uint32_t addr = 0; addr < list->count; addr++) {
+    actor_after(first, second);
+    actor_submit(first, ACTOR_READ, list, addr, 1);
+    actor_after(second, first);
+    actor_submit(second, ACTOR_READ, list, addr, 1);
   }
-//   set_process_affinity(primary_cores[2]);
-//   for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-//     void* target = address_list[3][cha][addr];
+  actor_sync(second);
 
-//     maccess(target);
-//     mfence();
-//   }
-
-  set_process_affinity(primary_cores[0]);
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
-    mfence();
-  }
+  set_process_affinity(ctx->primary_cores[0]);
 }
 
-void CONCAT(BENCH_NAME, _roi)(void* addr_list,
-                              int* primary_cores,
-                              int* secondary_cores,
-                              int* orchestrator_cores) {
-//   printf("%s: Running Region of Interest\n", EXPAND_AND_STRINGIFY(BENCH_NAME));
-
-  void*(*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
-
-  // set_process_affinity(primary_cores[3]);
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
-    maccess(target);
-    mfence();
-  }
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  // rdtscp stamps: no fence, nothing for the CHA counters to see
+  uint64_t start = timing_begin(TIMING_RDTSCP);
+  jit_run(st->roi_kernel);
+  uint64_t end = timing_end(TIMING_RDTSCP);
+  bench_report(ctx, "roi_read", (double)(end - start - timing_overhead[TIMING_RDTSCP]) / st->list->count,
+               "cycles/line");
 }
 
-void CONCAT(BENCH_NAME, _cleanup)(void* addr_list,
-                                  int* primary_cores,
-                                  int* secondary_cores,
-                                  int* orchestrator_cores) {
-//   printf("%s: Cleanup\n", EXPAND_AND_STRINGIFY(BENCH_NAME));
-
-  void*(*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
 
-  for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-    void* target = address_list[3][cha][addr];
+  for (uint32_t addr = 0; addr < st->list->count; addr++) {
+    void* target = pool_line(st->list, addr);
     flush(target);
     mfence();
   }
 }
 
-Benchmark benchmark = {EXPAND_AND_STRINGIFY(BENCH_NAME),
-                       CONCAT(BENCH_NAME, _init), CONCAT(BENCH_NAME, _roi),
-                       CONCAT(BENCH_NAME, _cleanup)};
+void CONCAT(BENCH_NAME, _teardown)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  jit_free(st->roi_kernel);
+  st->roi_kernel = NULL;
+}
+
+BenchmarkV2 benchmark_v2 = {BENCHMARK_ABI_VERSION, EXPAND_AND_STRINGIFY(BENCH_NAME),
+                            CONCAT(BENCH_NAME, _setup), CONCAT(BENCH_NAME, _init),
+                            CONCAT(BENCH_NAME, _roi), CONCAT(BENCH_NAME, _cleanup),
+                            CONCAT(BENCH_NAME, _teardown)};
@@ -4,6 +4,7 @@
 #include "socket_memory.h"
 #include "benchmark.h"
 #include "util.h"
+#include "actor.h"
 
 #define CONCAT(a, b) a##b
 #define STRINGIFY(x) #x
@@ -11,73 +12,88 @@
 
 // Access S3 memory: S1 read -> S2 read -> S0 read+check
 
-void CONCAT(BENCH_NAME, _init)(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
 
-    void* (*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+    addr_pool_t* pool = ctx->pool;
 
     for (int cha = 0; cha < NUM_CHA; cha++) {
-        for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-            void* target = address_list[3][cha][addr];
+        const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+        for (uint32_t addr = 0; addr < list->count; addr++) {
+            void* target = pool_line(list, addr);
             flush(target);
             mfence();
         }
     }
 
-    for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-        set_process_affinity(primary_cores[1]);
+    // Interleave the CHAs: one line of every CHA per round
+    uint32_t max_count = 0;
+    for (int cha = 0; cha < NUM_CHA; cha++) {
+        uint32_t count = pool_count(pool, pool_socket(pool, 3), cha);
+        if (count > max_count) max_count = count;
+    }
+
+    actor_t* first = actor_get(ctx->primary_cores[pool_socket(pool, 1)]);
+    actor_t* second = actor_get(ctx->primary_cores[pool_socket(pool, 2)]);
+    for (uint32_t addr = 0; addr < max_count; addr++) {
+        actor_after(first, second);
         for (int cha = 0; cha < NUM_CHA; cha++) {
-            void* target = address_list[3][cha][addr];
-            maccess(target);
-            mfence();
+            const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+            if (addr < list->count) actor_submit(first, ACTOR_READ, list, addr, 1);
         }
 
-        set_process_affinity(primary_cores[2]);
+        actor_after(second, first);
         for (int cha = 0; cha < NUM_CHA; cha++) {
-            void* target = address_list[3][cha][addr];
-            maccess(target);
-            mfence();
+            const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+            if (addr < list->count) actor_submit(second, ACTOR_READ, list, addr, 1);
         }
     }
+    actor_sync(second);
 
-    set_process_affinity(primary_cores[0]);
+    set_process_affinity(ctx->primary_cores[0]);
     for (int cha = 0; cha < NUM_CHA; cha++) {
-        for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-            void* target = address_list[3][cha][addr];
+        const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+        for (uint32_t addr = 0; addr < list->count; addr++) {
+            void* target = pool_line(list, addr);
             mfence();
         }
     }
 }
 
-void CONCAT(BENCH_NAME, _roi)(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
 
-    void* (*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+    addr_pool_t* pool = ctx->pool;
 
-    // set_process_affinity(primary_cores[3]);
+    // set_process_affinity(ctx->primary_cores[pool_socket(pool, 3)]);
     for (int cha = 0; cha < NUM_CHA; cha++) {
-        for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-            void* target = address_list[3][cha][addr];
+        const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+        for (uint32_t addr = 0; addr < list->count; addr++) {
+            void* target = pool_line(list, addr);
             maccess(target);
             mfence();
         }
     }
 }
 
-void CONCAT(BENCH_NAME, _cleanup)(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
 
-    void* (*address_list)[NUM_CHA][MAX_ADDRESSES] = addr_list;
+    addr_pool_t* pool = ctx->pool;
 
     for (int cha = 0; cha < NUM_CHA; cha++) {
-        for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-            void* target = address_list[3][cha][addr];
+        const pool_list_t* list = pool_list(pool, pool_socket(pool, 3), cha);
+        for (uint32_t addr = 0; addr < list->count; addr++) {
+            void* target = pool_line(list, addr);
             flush(target);
             mfence();
         }
     }
 }
 
-Benchmark benchmark = {
+BenchmarkV2 benchmark_v2 = {
+    BENCHMARK_ABI_VERSION,
     EXPAND_AND_STRINGIFY(BENCH_NAME),
+    NULL,
     CONCAT(BENCH_NAME, _init),
     CONCAT(BENCH_NAME, _roi),
-    CONCAT(BENCH_NAME, _cleanup)
+    CONCAT(BENCH_NAME, _cleanup),
+    NULL
 };
@@ -0,0 +1,332 @@
+#define BENCH_NAME cha_bandwidth
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "benchmark.h"
+#include "socket_memory.h"
+#include "util.h"
+#include "actor.h"
+#include "timing.h"
+#include "topology.h"
+#include "curve.h"
+
+#define CONCAT(a, b) a##b
+#define STRINGIFY(x) #x
+#define EXPAND_AND_STRINGIFY(x) STRINGIFY(x)
+
+// How much traffic one CHA absorbs before it is the bottleneck. threads
+// actors on the worker cores of the req socket stream, unfenced, over
+// disjoint parts of the lines homed at one CHA, all starting at the same TSC
+// deadline; spread=1 streams the same number of lines taken round-robin from
+// every CHA of the home socket instead. Lines start flushed.
+//
+// Parameters: cha (default 1), home socket of the lines (default 0), req
+// socket of the streaming cores (default 0), threads (default 1), op (read,
+// write: full-line stores, rfo: one 8-byte store per line; default read),
+// kernel (scalar, avx2, avx512 or auto, the widest the CPU has; rfo is
+// always scalar), spread (default 0), lines (default all the mapping found
+// for the CHA; raise --lines-per-cha for a longer stream). Each thread needs
+// at least MIN_STREAM_LINES: shorter streams time the release skew of the
+// group, not the CHA.
+//
+// Sweep threads to get the scaling curve: each parameter set appends its mean
+// GB/s to output/current/cha_bandwidth_points.log under the key of its other
+// parameters, and teardown rebuilds output/current/cha_bandwidth_scaling.log
+// with every curve and its knee from all points recorded so far, so a resumed
+// sweep still reports the points it skipped.
+
+#define MAX_STREAMS MAX_ACTORS
+#define MIN_STREAM_LINES 1024  // Per thread, 64 KiB
+#define KNEE_FRACTION 0.2  // Knee: an added thread brings less than this share of a lone thread's GB/s
+
+typedef enum { STREAM_READ, STREAM_WRITE, STREAM_RFO } stream_op_t;
+typedef enum { KERNEL_SCALAR, KERNEL_AVX2, KERNEL_AVX512 } kernel_t;
+
+static const char* op_names[] = {"read", "write", "rfo"};
+static const char* kernel_names[] = {"scalar", "avx2", "avx512"};
+
+// One actor's share of the lines
+typedef struct {
+  void** lines;
+  uint32_t count;
+  stream_op_t op;
+  kernel_t kernel;
+  int64_t tsc_offset;
+  uint64_t end_tsc;  // Orchestrator TSC
+} __attribute__((aligned(CACHE_LINE_SIZE))) stream_t;
+
+typedef struct {
+  int cha;
+  int home;
+  int req;
+  int threads;
+  int spread;
+  stream_op_t op;
+  kernel_t kernel;
+  uint32_t lines;
+  void** line_list;
+  actor_t* actors[MAX_STREAMS];
+  stream_t streams[MAX_STREAMS];
+  actor_group_t group;
+  double sum;
+  int samples;
+  char key[CURVE_KEY_LEN];
+} state_t;
+
+static state_t state;
+
+#define STREAM(body)                                                        \
+  for (uint32_t i = 0; i < n; i++) {                                        \
+    asm volatile(body ::"r"(lines[i]) : "rax", "xmm0", "memory");           \
+  }
+
+#define SCALAR_LOADS                                                                                     \
+  "mov (%0), %%rax\n\tmov 8(%0), %%rax\n\tmov 16(%0), %%rax\n\tmov 24(%0), %%rax\n\t" \
+  "mov 32(%0), %%rax\n\tmov 40(%0), %%rax\n\tmov 48(%0), %%rax\n\tmov 56(%0), %%rax"
+#define SCALAR_STORES                                                                                    \
+  "movq $0, (%0)\n\tmovq $0, 8(%0)\n\tmovq $0, 16(%0)\n\tmovq $0, 24(%0)\n\t" \
+  "movq $0, 32(%0)\n\tmovq $0, 40(%0)\n\tmovq $0, 48(%0)\n\tmovq $0, 56(%0)"
+
+// Runs on the actor, from the group deadline on
+static void stream_lines(void* arg) {
+  stream_t* s = arg;
+  void** lines = s->lines;
+  uint32_t n = s->count;
+
+  if (s->op == STREAM_RFO) {
+    STREAM("movq $0, (%0)");
+  } else if (s->kernel == KERNEL_AVX512) {
+    if (s->op == STREAM_READ) {
+      STREAM("vmovdqa64 (%0), %%zmm0");
+    } else {
+      STREAM("vmovdqa64 %%zmm0, (%0)");
+    }
+    asm volatile("vzeroupper");
+  } else if (s->kernel == KERNEL_AVX2) {
+    if (s->op == STREAM_READ) {
+      STREAM("vmovdqa (%0), %%ymm0\n\tvmovdqa 32(%0), %%ymm0");
+    } else {
+      STREAM("vmovdqa %%ymm0, (%0)\n\tvmovdqa %%ymm0, 32(%0)");
+    }
+    asm volatile("vzeroupper");
+  } else if (s->op == STREAM_READ) {
+    STREAM(SCALAR_LOADS);
+  } else {
+    STREAM(SCALAR_STORES);
+  }
+
+  // The stream is done once its stores have drained
+  mfence();
+  s->end_tsc = timing_end(TIMING_RDTSCP) - s->tsc_offset;
+}
+
+static int parse_kernel(const char* name, kernel_t* kernel) {
+  int avx2 = __builtin_cpu_supports("avx2");
+  int avx512 = __builtin_cpu_supports("avx512f");
+  if (strcmp(name, "auto") == 0) {
+    *kernel = avx512 ? KERNEL_AVX512 : avx2 ? KERNEL_AVX2 : KERNEL_SCALAR;
+  } else if (strcmp(name, "avx512") == 0 && avx512) {
+    *kernel = KERNEL_AVX512;
+  } else if (strcmp(name, "avx2") == 0 && avx2) {
+    *kernel = KERNEL_AVX2;
+  } else if (strcmp(name, "scalar") == 0) {
+    *kernel = KERNEL_SCALAR;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+// The stream's lines: the CHA's own, or as many taken round-robin from all
+static int collect_lines(bench_ctx_t* ctx, state_t* st) {
+  const pool_list_t* list = pool_list(ctx->pool, st->home, st->cha);
+  if (!list || list->count == 0) return -1;
+  st->lines = bench_param_long(ctx, "lines", list->count);
+  if (st->lines == 0) st->lines = list->count;
+  if (!st->spread && st->lines > list->count) st->lines = list->count;
+
+  void** line_list = realloc(st->line_list, st->lines * sizeof(void*));
+  if (!line_list) return -1;
+  st->line_list = line_list;
+  for (uint32_t i = 0; i < st->lines; i++) {
+    int cha = st->spread ? (int)(i % ctx->num_chas) : st->cha;
+    uint32_t idx = st->spread ? i / ctx->num_chas : i;
+    list = pool_list(ctx->pool, st->home, cha);
+    if (!list || idx >= list->count) {
+      fprintf(stderr, "%s: CHA %d has fewer than %u lines to spread over\n", EXPAND_AND_STRINGIFY(BENCH_NAME), cha,
+              idx + 1);
+      return -1;
+    }
+    st->line_list[i] = pool_line(list, idx);
+  }
+  return 0;
+}
+
+// Point of the last thread count before an added thread brings less than
+// KNEE_FRACTION of what one thread streams alone; points are x = threads,
+// y[0] = GB/s, sorted by threads
+static const curve_point_t* find_knee(const curve_t* curve) {
+  const curve_point_t* knee = NULL;
+  double single = 0;
+  for (int i = 0; i < curve->num_points; i++) {
+    const curve_point_t* point = &curve->points[i];
+    if (!knee) {
+      single = point->y[0] / point->x;
+    } else if ((point->y[0] - knee->y[0]) / (point->x - knee->x) < KNEE_FRACTION * single) {
+      break;
+    }
+    knee = point;
+  }
+  return knee;
+}
+
+static void write_curves(const curve_t* curves, int num_curves) {
+  FILE* fp = fopen("output/current/" EXPAND_AND_STRINGIFY(BENCH_NAME) "_scaling.log", "w");
+  if (!fp) {
+    perror("fopen scaling log");
+    return;
+  }
+  for (int c = 0; c < num_curves; c++) {
+    const curve_t* curve = &curves[c];
+    double peak = 0;
+    fprintf(fp, "# %s\n%-8s %-10s\n", curve->key, "Threads", "GB/s");
+    for (int i = 0; i < curve->num_points; i++) {
+      fprintf(fp, "%-8.0f %-10.2f\n", curve->points[i].x, curve->points[i].y[0]);
+      if (curve->points[i].y[0] > peak) peak = curve->points[i].y[0];
+    }
+    const curve_point_t* knee = find_knee(curve);
+    if (knee) fprintf(fp, "Knee: %.0f threads, %.2f GB/s; peak %.2f GB/s\n\n", knee->x, knee->y[0], peak);
+  }
+  fclose(fp);
+}
+
+int CONCAT(BENCH_NAME, _setup)(bench_ctx_t* ctx) {
+  state.cha = bench_param_long(ctx, "cha", 1);
+  if (state.cha < 0 || state.cha >= ctx->num_chas) {
+    fprintf(stderr, "%s: no CHA %d\n", EXPAND_AND_STRINGIFY(BENCH_NAME), state.cha);
+    return -1;
+  }
+  const char* op = bench_param(ctx, "op", "read");
+  state.op = strcmp(op, "write") == 0 ? STREAM_WRITE : strcmp(op, "rfo") == 0 ? STREAM_RFO : STREAM_READ;
+  const char* kernel = bench_param(ctx, "kernel", "auto");
+  if (parse_kernel(kernel, &state.kernel) != 0) {
+    fprintf(stderr, "%s: kernel %s not available\n", EXPAND_AND_STRINGIFY(BENCH_NAME), kernel);
+    return -1;
+  }
+  if (state.op == STREAM_RFO) state.kernel = KERNEL_SCALAR;
+
+  state.home = bench_param_socket(ctx, "home", 0);
+  state.req = bench_param_socket(ctx, "req", 0);
+  if (state.home < 0 || state.req < 0) return -1;
+  state.spread = bench_param_long(ctx, "spread", 0) != 0;
+  state.threads = bench_param_long(ctx, "threads", 1);
+  int cores[MAX_STREAMS];
+  int num_cores = socket_worker_cores(state.req, cores, MAX_STREAMS);
+  if (state.threads < 1 || state.threads > num_cores) {
+    fprintf(stderr, "%s: threads must be in [1, %d] on socket %d\n", EXPAND_AND_STRINGIFY(BENCH_NAME), num_cores,
+            state.req);
+    return -1;
+  }
+  if (collect_lines(ctx, &state) != 0) return -1;
+  if (state.lines < (uint64_t)state.threads * MIN_STREAM_LINES) {
+    fprintf(stderr, "%s: %u lines leave under %d per thread for %d threads; raise lines and --lines-per-cha\n",
+            EXPAND_AND_STRINGIFY(BENCH_NAME), state.lines, MIN_STREAM_LINES, state.threads);
+    return -1;
+  }
+
+  // Offsets are measured against the core the ROI releases the group from
+  if (ctx->orchestrator_cores[0] >= 0) set_process_affinity(ctx->orchestrator_cores[0]);
+  for (int t = 0; t < state.threads; t++) {
+    state.actors[t] = actor_get(cores[t]);
+    if (!state.actors[t]) return -1;
+
+    stream_t* s = &state.streams[t];
+    uint32_t first = (uint64_t)state.lines * t / state.threads;
+    s->lines = state.line_list + first;
+    s->count = (uint64_t)state.lines * (t + 1) / state.threads - first;
+    s->op = state.op;
+    s->kernel = state.kernel;
+    s->tsc_offset = actor_tsc_offset(state.actors[t]);
+  }
+
+  snprintf(state.key, sizeof(state.key), "cha %d home %d req %d op %s kernel %s spread %d lines %u",
+           state.cha, state.home, state.req, op_names[state.op], kernel_names[state.kernel], state.spread,
+           state.lines);
+  printf("%s: %s, %d threads\n", EXPAND_AND_STRINGIFY(BENCH_NAME), state.key, state.threads);
+  state.sum = 0;
+  state.samples = 0;
+  ctx->priv = &state;
+  return 0;
+}
+
+// Park every actor at the group, its stream queued behind the deadline
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  for (uint32_t i = 0; i < st->lines; i++) {
+    flush(st->line_list[i]);
+  }
+  mfence();
+
+  if (ctx->orchestrator_cores[0] >= 0) set_process_affinity(ctx->orchestrator_cores[0]);
+  actor_group_init(&st->group);
+  for (int t = 0; t < st->threads; t++) {
+    actor_at(st->actors[t], &st->group);
+    actor_call(st->actors[t], stream_lines, &st->streams[t]);
+  }
+}
+
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  actor_group_release(&st->group, ACTOR_GROUP_LEAD);
+  for (int t = 0; t < st->threads; t++) {
+    actor_sync(st->actors[t]);
+  }
+
+  // From the first start to the last end
+  uint64_t start = UINT64_MAX, end = 0;
+  for (int t = 0; t < st->threads; t++) {
+    if (st->actors[t]->start_tsc < start) start = st->actors[t]->start_tsc;
+    if (st->streams[t].end_tsc > end) end = st->streams[t].end_tsc;
+  }
+  if (tsc_ghz <= 0 || end <= start) return;
+
+  double gbps = (double)st->lines * CACHE_LINE_SIZE / ((end - start) / tsc_ghz);
+  bench_report(ctx, "bandwidth", gbps, "GB/s");
+  bench_report(ctx, "per_thread", gbps / st->threads, "GB/s");
+  st->sum += gbps;
+  st->samples++;
+}
+
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  actor_group_cancel(&st->group, st->actors, st->threads);
+  for (uint32_t i = 0; i < st->lines; i++) {
+    flush(st->line_list[i]);
+  }
+  mfence();
+}
+
+// Record this thread count and rebuild the scaling log from every point
+void CONCAT(BENCH_NAME, _teardown)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  curve_point_t point = {st->threads, {st->samples > 0 ? st->sum / st->samples : 0}};
+  if (st->samples > 0 && curve_add_point(EXPAND_AND_STRINGIFY(BENCH_NAME), st->key, &point) == 0) {
+    static curve_t curves[MAX_CURVES];
+    int num_curves = curve_load(EXPAND_AND_STRINGIFY(BENCH_NAME), curves, MAX_CURVES);
+    for (int c = 0; c < num_curves; c++) {
+      if (strcmp(curves[c].key, st->key) != 0) continue;
+      const curve_point_t* knee = find_knee(&curves[c]);
+      if (knee) printf("%s: knee so far at %.0f threads, %.2f GB/s\n", EXPAND_AND_STRINGIFY(BENCH_NAME), knee->x,
+                       knee->y[0]);
+    }
+    write_curves(curves, num_curves);
+  }
+  free(st->line_list);
+  st->line_list = NULL;
+}
+
+BenchmarkV2 benchmark_v2 = {BENCHMARK_ABI_VERSION, EXPAND_AND_STRINGIFY(BENCH_NAME),
+                            CONCAT(BENCH_NAME, _setup), CONCAT(BENCH_NAME, _init),
+                            CONCAT(BENCH_NAME, _roi), CONCAT(BENCH_NAME, _cleanup),
+                            CONCAT(BENCH_NAME, _teardown)};
@@ -0,0 +1,127 @@
+#define BENCH_NAME contention
+
+#include <stdio.h>
+#include <string.h>
+#include "benchmark.h"
+#include "socket_memory.h"
+#include "util.h"
+#include "actor.h"
+#include "timing.h"
+
+#define CONCAT(a, b) a##b
+#define STRINGIFY(x) #x
+#define EXPAND_AND_STRINGIFY(x) STRINGIFY(x)
+
+// The primary and secondary cores of every socket hit the same lines of one
+// CHA at the same TSC deadline, with the counters running. Each actor times
+// its own accesses; the per-actor percentiles show who wins the line and
+// what the losers pay.
+//
+// Parameters: cha (default 1), home socket of the lines (default 0), op
+// (read, write or atomic; default write), secondary (also use the secondary
+// cores, default 1), lines (default all the mapping found for the CHA).
+
+#define MAX_CONTENDERS (2 * MAX_SOCKETS)
+
+typedef struct {
+  int cha;
+  int home;
+  actor_op_t op;
+  uint32_t lines;
+  const pool_list_t* list;
+  actor_t* actors[MAX_CONTENDERS];
+  int sockets[MAX_CONTENDERS];
+  int num_actors;
+  actor_group_t group;
+} state_t;
+
+static state_t state;
+static timing_buffer_t* latency[MAX_CONTENDERS];
+static char labels[MAX_CONTENDERS][32];
+
+static void flush_lines(const state_t* st) {
+  for (uint32_t addr = 0; addr < st->lines; addr++) {
+    flush(pool_line(st->list, addr));
+    mfence();
+  }
+}
+
+int CONCAT(BENCH_NAME, _setup)(bench_ctx_t* ctx) {
+  state.cha = bench_param_long(ctx, "cha", 1);
+  if (state.cha < 0 || state.cha >= ctx->num_chas) {
+    fprintf(stderr, "%s: no CHA %d\n", EXPAND_AND_STRINGIFY(BENCH_NAME), state.cha);
+    return -1;
+  }
+
+  const char* op = bench_param(ctx, "op", "write");
+  state.op = strcmp(op, "read") == 0 ? ACTOR_READ : strcmp(op, "atomic") == 0 ? ACTOR_ATOMIC : ACTOR_WRITE;
+  state.home = bench_param_socket(ctx, "home", 0);
+  if (state.home < 0) return -1;
+  state.list = pool_list(ctx->pool, state.home, state.cha);
+  if (!state.list || state.list->count == 0) return -1;
+  state.lines = bench_param_long(ctx, "lines", state.list->count);
+  if (state.lines == 0 || state.lines > state.list->count) state.lines = state.list->count;
+
+  // Offsets are measured against the core the ROI releases the group from
+  set_process_affinity(ctx->orchestrator_cores[0]);
+  int secondary = bench_param_long(ctx, "secondary", 1) != 0;
+  state.num_actors = 0;
+  for (int socket_id = 0; socket_id < ctx->num_sockets; socket_id++) {
+    for (int second = 0; second <= secondary; second++) {
+      int core = second ? ctx->secondary_cores[socket_id] : ctx->primary_cores[socket_id];
+      actor_t* actor = core >= 0 ? bench_actor(ctx, socket_id, second) : NULL;
+      if (!actor) continue;
+
+      int i = state.num_actors++;
+      state.actors[i] = actor;
+      state.sockets[i] = socket_id;
+      if (!latency[i]) {
+        snprintf(labels[i], sizeof(labels[i]), "%s actor %d", EXPAND_AND_STRINGIFY(BENCH_NAME), i);
+        latency[i] = timing_buffer_create(labels[i], TIMING_RDTSCP, pool_lines_per_cha);
+        if (latency[i]) timing_buffer_histograms(latency[i]);
+      }
+      printf("%s: actor %d on core %d (socket %d), TSC offset %ld\n", EXPAND_AND_STRINGIFY(BENCH_NAME), i,
+             core, socket_id, (long)actor_tsc_offset(actor));
+    }
+  }
+
+  ctx->priv = &state;
+  return state.num_actors >= 2 ? 0 : -1;
+}
+
+// Park every actor at the group, its stream queued behind the deadline
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  flush_lines(st);
+
+  set_process_affinity(ctx->orchestrator_cores[0]);
+  actor_group_init(&st->group);
+  for (int i = 0; i < st->num_actors; i++) {
+    actor_at(st->actors[i], &st->group);
+    actor_submit_timed(st->actors[i], st->op, st->list, 0, st->lines, latency[i],
+                       TIMING_KEY(st->sockets[i], st->home, st->cha, 0));
+  }
+}
+
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  uint64_t deadline = actor_group_release(&st->group, ACTOR_GROUP_LEAD);
+  for (int i = 0; i < st->num_actors; i++) {
+    actor_sync(st->actors[i]);
+  }
+
+  // How far each start missed the deadline, orchestrator TSC
+  for (int i = 0; i < st->num_actors; i++) {
+    bench_report(ctx, labels[i], (double)(int64_t)(st->actors[i]->start_tsc - deadline), "cycles late");
+  }
+}
+
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  actor_group_cancel(&st->group, st->actors, st->num_actors);
+  flush_lines(st);
+}
+
+BenchmarkV2 benchmark_v2 = {BENCHMARK_ABI_VERSION, EXPAND_AND_STRINGIFY(BENCH_NAME),
+                            CONCAT(BENCH_NAME, _setup), CONCAT(BENCH_NAME, _init),
+                            CONCAT(BENCH_NAME, _roi), CONCAT(BENCH_NAME, _cleanup), NULL};
@@ -0,0 +1,72 @@
+#define BENCH_NAME llc_hit_latency
+
+#include <stdio.h>
+#include "socket_memory.h"
+#include "benchmark.h"
+#include "evset.h"
+#include "util.h"
+#include "timing.h"
+
+#define CONCAT(a, b) a##b
+#define STRINGIFY(x) #x
+#define EXPAND_AND_STRINGIFY(x) STRINGIFY(x)
+
+// LLC hit latency of every CHA of socket 0 from the primary core of socket 0.
+// One line per CHA is loaded and pushed out of L1/L2 with a private eviction
+// set, so the timed read is served by that CHA's slice.
+
+#define HOME_SOCKET 0
+
+static private_evset_t private_sets[NUM_CHA];
+static int have_set[NUM_CHA];
+static int prepared = 0;
+static timing_buffer_t* samples = NULL;  // Percentiles per CHA, reported after the runs
+
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
+    addr_pool_t* pool = ctx->pool;
+    int socket_id = pool_socket(pool, HOME_SOCKET);
+
+    set_process_affinity(ctx->primary_cores[socket_id]);
+    if (!prepared) {
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            have_set[cha] = pool_count(pool, socket_id, cha) > 0 &&
+                            private_evset_build(&private_sets[cha], pool_addr(pool, socket_id, cha, 0)) > 0;
+        }
+        samples = timing_buffer_create(EXPAND_AND_STRINGIFY(BENCH_NAME), TIMING_LFENCE, NUM_CHA);
+        if (samples) timing_buffer_histograms(samples);
+        prepared = 1;
+    }
+
+    for (int cha = 0; cha < NUM_CHA; cha++) {
+        if (!have_set[cha]) continue;
+        maccess(private_sets[cha].target);
+        mfence();
+        evict_to_llc(&private_sets[cha]);
+    }
+}
+
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
+    uint64_t start, end;
+
+    if (!samples) return;
+    for (int cha = 0; cha < NUM_CHA; cha++) {
+        if (!have_set[cha]) continue;
+        start = timing_begin(TIMING_LFENCE);
+        maccess(private_sets[cha].target);
+        end = timing_end(TIMING_LFENCE);
+        timing_record(samples, TIMING_KEY(HOME_SOCKET, HOME_SOCKET, cha, 0), start, end);
+    }
+}
+
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
+}
+
+BenchmarkV2 benchmark_v2 = {
+    BENCHMARK_ABI_VERSION,
+    EXPAND_AND_STRINGIFY(BENCH_NAME),
+    NULL,
+    CONCAT(BENCH_NAME, _init),
+    CONCAT(BENCH_NAME, _roi),
+    CONCAT(BENCH_NAME, _cleanup),
+    NULL
+};
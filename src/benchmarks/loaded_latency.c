@@ -0,0 +1,315 @@
+#define BENCH_NAME loaded_latency
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "benchmark.h"
+#include "socket_memory.h"
+#include "util.h"
+#include "actor.h"
+#include "timing.h"
+#include "curve.h"
+
+#define CONCAT(a, b) a##b
+#define STRINGIFY(x) #x
+#define EXPAND_AND_STRINGIFY(x) STRINGIFY(x)
+
+// Pointer-chase latency to one CHA while generator actors load the uncore.
+// The primary core of the req socket walks a random chain through lines
+// homed at the CHA; the generators, on other physical cores, touch and
+// flush lines homed at their own targets at a paced rate, so each access
+// reaches a CHA. They start at a TSC deadline, run through the whole chase
+// and stop once it is done.
+//
+// Parameters: cha (default 1), home socket of the chased lines (default 0),
+// req socket of the chasing core (default 0), lines in the chain (default
+// half the CHA's lines, the rest are left to the generators), generators
+// (default 2) or cores (colon-separated list, e.g. 4:6:8; cores on the
+// chasing core's physical core are dropped), gen_socket (default req), gen_home (default home), gen_cha (-1 for every CHA of
+// gen_home, the default), gen_op (read or write, default read), rate per
+// generator in MB/s (0, the default, runs flat out), seed (default 1).
+//
+// Sweep rate to get the curve: teardown appends the set's mean generator
+// GB/s and chase latency to output/current/loaded_latency_points.log under
+// the key of its other parameters, then rebuilds
+// output/current/loaded_latency_curve.log from every point recorded so far.
+
+#define MAX_GENERATORS (MAX_ACTORS - 1)
+#define SETTLE_CYCLES 100000  // Generators run this long before the chase starts
+
+typedef struct {
+  void** lines;
+  uint32_t count;
+  int write;
+  uint64_t interval;          // Cycles between accesses, 0 for flat out
+  volatile int* stop;
+  int64_t tsc_offset;
+  uint64_t done;              // Lines touched
+  uint64_t end_tsc;           // Orchestrator TSC
+} __attribute__((aligned(CACHE_LINE_SIZE))) generator_t;
+
+typedef struct {
+  int cha;
+  int home;
+  int req;
+  int gen_home;
+  int gen_cha;
+  uint32_t lines;
+  uint64_t seed;
+  double rate;
+  const pool_list_t* list;
+  uint32_t* order;  // Chain order of the lines
+  void* head;
+  void** gen_lines;
+  uint32_t num_gen_lines;
+  int num_generators;
+  actor_t* actors[MAX_GENERATORS];
+  generator_t generators[MAX_GENERATORS];
+  actor_group_t group;
+  volatile int stop __attribute__((aligned(CACHE_LINE_SIZE)));
+  double load_sum;
+  double latency_sum;
+  int samples;
+  char key[CURVE_KEY_LEN];
+} state_t;
+
+static state_t state;
+
+// Runs on the actor, from the group deadline until the chase is done
+static void generate(void* arg) {
+  generator_t* g = arg;
+  uint64_t start = timing_begin(TIMING_RDTSCP);
+  uint64_t next = start;
+  uint64_t done = 0;
+  uint32_t i = 0;
+
+  while (!*g->stop) {
+    if (g->interval) {
+      uint64_t now;
+      while ((int64_t)((now = timing_begin(TIMING_RDTSCP)) - next) < 0) {
+      }
+      // Behind schedule: pick up from now rather than burst to catch up
+      next = (int64_t)(now - next) > (int64_t)g->interval ? now + g->interval : next + g->interval;
+    }
+    void* line = g->lines[i];
+    if (g->write) {
+      mmodify(line);
+    } else {
+      maccess(line);
+    }
+    flush(line);
+    if (++i == g->count) i = 0;
+    done++;
+  }
+
+  g->done = done;
+  g->end_tsc = timing_end(TIMING_RDTSCP) - g->tsc_offset;
+}
+
+// Every line of the chain stores the address of the next one
+static void build_chain(state_t* st) {
+  const uint32_t* order = st->order;
+  for (uint32_t i = 0; i < st->lines; i++) {
+    *(void**)pool_line(st->list, order[i]) = pool_line(st->list, order[(i + 1) % st->lines]);
+  }
+  st->head = pool_line(st->list, order[0]);
+}
+
+// Generator lines, round-robin over the targeted CHAs; the chained lines
+// are left out
+static int collect_gen_lines(bench_ctx_t* ctx, state_t* st) {
+  int first_cha = st->gen_cha < 0 ? 0 : st->gen_cha;
+  int last_cha = st->gen_cha < 0 ? ctx->num_chas - 1 : st->gen_cha;
+  uint32_t max_count = 0, total = 0;
+  for (int cha = first_cha; cha <= last_cha; cha++) {
+    uint32_t count = pool_count(ctx->pool, st->gen_home, cha);
+    if (count > max_count) max_count = count;
+    total += count;
+  }
+
+  void** gen_lines = realloc(st->gen_lines, (total ? total : 1) * sizeof(void*));
+  if (!gen_lines) return -1;
+  st->gen_lines = gen_lines;
+  st->num_gen_lines = 0;
+  for (uint32_t idx = 0; idx < max_count; idx++) {
+    for (int cha = first_cha; cha <= last_cha; cha++) {
+      if (cha == st->cha && st->gen_home == st->home && idx < st->lines) continue;
+      if (idx < pool_count(ctx->pool, st->gen_home, cha)) {
+        st->gen_lines[st->num_gen_lines++] = pool_addr(ctx->pool, st->gen_home, cha, idx);
+      }
+    }
+  }
+  return st->num_gen_lines >= (uint32_t)st->num_generators ? 0 : -1;
+}
+
+// Curve points: x = rate, y[0] = achieved GB/s of all generators, y[1] = ns
+// per hop; rows go by load
+static int compare_load(const void* a, const void* b) {
+  double diff = ((const curve_point_t*)a)->y[0] - ((const curve_point_t*)b)->y[0];
+  return (diff > 0) - (diff < 0);
+}
+
+static void write_curves(curve_t* curves, int num_curves) {
+  FILE* fp = fopen("output/current/" EXPAND_AND_STRINGIFY(BENCH_NAME) "_curve.log", "w");
+  if (!fp) {
+    perror("fopen curve log");
+    return;
+  }
+  for (int c = 0; c < num_curves; c++) {
+    curve_t* curve = &curves[c];
+    qsort(curve->points, curve->num_points, sizeof(curve_point_t), compare_load);
+    fprintf(fp, "# %s\n%-12s %-12s %-12s\n", curve->key, "Rate MB/s", "Load GB/s", "Latency ns");
+    for (int i = 0; i < curve->num_points; i++) {
+      fprintf(fp, "%-12.0f %-12.2f %-12.2f\n", curve->points[i].x, curve->points[i].y[0], curve->points[i].y[1]);
+    }
+    fprintf(fp, "\n");
+  }
+  fclose(fp);
+}
+
+int CONCAT(BENCH_NAME, _setup)(bench_ctx_t* ctx) {
+  state.cha = bench_param_long(ctx, "cha", 1);
+  if (state.cha < 0 || state.cha >= ctx->num_chas) {
+    fprintf(stderr, "%s: no CHA %d\n", EXPAND_AND_STRINGIFY(BENCH_NAME), state.cha);
+    return -1;
+  }
+  state.home = bench_param_socket(ctx, "home", 0);
+  state.req = bench_param_socket(ctx, "req", 0);
+  state.gen_home = bench_param_socket(ctx, "gen_home", state.home);
+  if (state.home < 0 || state.req < 0 || state.gen_home < 0) return -1;
+  state.gen_cha = bench_param_long(ctx, "gen_cha", -1);
+  if (state.gen_cha >= ctx->num_chas || ctx->primary_cores[state.req] < 0) return -1;
+  state.seed = bench_param_long(ctx, "seed", 1);
+  state.rate = bench_param_long(ctx, "rate", 0);
+
+  state.list = pool_list(ctx->pool, state.home, state.cha);
+  if (!state.list || state.list->count < 2) return -1;
+  state.lines = bench_param_long(ctx, "lines", state.list->count / 2);
+  if (state.lines < 2 || state.lines > state.list->count) state.lines = state.list->count / 2;
+  free(state.order);
+  state.order = bench_shuffled_order(state.lines, state.seed);
+  if (!state.order) return -1;
+
+  // Generators stay off the chasing core's physical core
+  int gen_socket = bench_param_socket(ctx, "gen_socket", state.req);
+  if (gen_socket < 0) return -1;
+  int cores[MAX_GENERATORS];
+  state.num_generators = bench_param_cores(ctx, "cores", gen_socket, bench_param_long(ctx, "generators", 2),
+                                           ctx->primary_cores[state.req], cores, MAX_GENERATORS);
+  if (state.num_generators < 1) {
+    fprintf(stderr, "%s: not enough generator cores\n", EXPAND_AND_STRINGIFY(BENCH_NAME));
+    return -1;
+  }
+  if (collect_gen_lines(ctx, &state) != 0) return -1;
+
+  // The chasing core also releases the group: offsets are measured from it
+  set_process_affinity(ctx->primary_cores[state.req]);
+  int write = strcmp(bench_param(ctx, "gen_op", "read"), "write") == 0;
+  uint64_t interval = state.rate > 0 && tsc_ghz > 0 ? CACHE_LINE_SIZE / (state.rate * 1e6) * tsc_ghz * 1e9 : 0;
+  for (int g = 0; g < state.num_generators; g++) {
+    state.actors[g] = actor_get(cores[g]);
+    if (!state.actors[g]) return -1;
+
+    generator_t* gen = &state.generators[g];
+    uint32_t first = (uint64_t)state.num_gen_lines * g / state.num_generators;
+    gen->lines = state.gen_lines + first;
+    gen->count = (uint64_t)state.num_gen_lines * (g + 1) / state.num_generators - first;
+    gen->write = write;
+    gen->interval = interval;
+    gen->stop = &state.stop;
+    gen->tsc_offset = actor_tsc_offset(state.actors[g]);
+    printf("%s: generator %d on core %d, %u lines\n", EXPAND_AND_STRINGIFY(BENCH_NAME), g, cores[g], gen->count);
+  }
+
+  int len = snprintf(state.key, sizeof(state.key),
+                     "cha %d home %d req %d lines %u gen_socket %d gen_home %d gen_cha %d gen_op %s cores",
+                     state.cha, state.home, state.req, state.lines, gen_socket, state.gen_home, state.gen_cha,
+                     write ? "write" : "read");
+  for (int g = 0; g < state.num_generators && len < (int)sizeof(state.key); g++) {
+    len += snprintf(state.key + len, sizeof(state.key) - len, "%s%d", g ? ":" : " ", cores[g]);
+  }
+  state.load_sum = 0;
+  state.latency_sum = 0;
+  state.samples = 0;
+  ctx->priv = &state;
+  return 0;
+}
+
+// Chain flushed, generators parked at the group
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  set_process_affinity(ctx->primary_cores[st->req]);
+  build_chain(st);
+  for (uint32_t addr = 0; addr < st->lines; addr++) {
+    flush(pool_line(st->list, addr));
+  }
+  mfence();
+
+  st->stop = 0;
+  actor_group_init(&st->group);
+  for (int g = 0; g < st->num_generators; g++) {
+    actor_at(st->actors[g], &st->group);
+    actor_call(st->actors[g], generate, &st->generators[g]);
+  }
+}
+
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  uint64_t deadline = actor_group_release(&st->group, ACTOR_GROUP_LEAD);
+  while ((int64_t)(timing_begin(TIMING_RDTSCP) - deadline - SETTLE_CYCLES) < 0) {
+  }
+
+  void* p = st->head;
+  uint64_t n = st->lines;
+  uint64_t start = timing_begin(TIMING_RDTSCP);
+  asm volatile("1:\n\tmov (%0), %0\n\tdec %1\n\tjnz 1b" : "+r"(p), "+r"(n)::"memory");
+  uint64_t end = timing_end(TIMING_RDTSCP);
+
+  st->stop = 1;
+  for (int g = 0; g < st->num_generators; g++) {
+    actor_sync(st->actors[g]);
+  }
+  if (tsc_ghz <= 0) return;
+
+  double load = 0;
+  for (int g = 0; g < st->num_generators; g++) {
+    uint64_t gen_start = st->actors[g]->start_tsc;
+    uint64_t gen_end = st->generators[g].end_tsc;
+    if (gen_end > gen_start) load += st->generators[g].done * CACHE_LINE_SIZE / ((gen_end - gen_start) / tsc_ghz);
+  }
+  double latency = (double)(end - start - timing_overhead[TIMING_RDTSCP]) / st->lines / tsc_ghz;
+  bench_report(ctx, "hop_latency_ns", latency, "ns");
+  bench_report(ctx, "generator_load", load, "GB/s");
+  st->load_sum += load;
+  st->latency_sum += latency;
+  st->samples++;
+}
+
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  // A cancelled group must find its generators already stopped
+  st->stop = 1;
+  actor_group_cancel(&st->group, st->actors, st->num_generators);
+  for (uint32_t addr = 0; addr < st->lines; addr++) {
+    flush(pool_line(st->list, addr));
+  }
+  mfence();
+}
+
+// Record this rate and rebuild the curve log from every point
+void CONCAT(BENCH_NAME, _teardown)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  free(st->order);
+  st->order = NULL;
+  if (st->samples == 0) return;
+
+  curve_point_t point = {st->rate, {st->load_sum / st->samples, st->latency_sum / st->samples}};
+  if (curve_add_point(EXPAND_AND_STRINGIFY(BENCH_NAME), st->key, &point) != 0) return;
+  static curve_t curves[MAX_CURVES];
+  write_curves(curves, curve_load(EXPAND_AND_STRINGIFY(BENCH_NAME), curves, MAX_CURVES));
+}
+
+BenchmarkV2 benchmark_v2 = {BENCHMARK_ABI_VERSION, EXPAND_AND_STRINGIFY(BENCH_NAME),
+                            CONCAT(BENCH_NAME, _setup), CONCAT(BENCH_NAME, _init),
+                            CONCAT(BENCH_NAME, _roi), CONCAT(BENCH_NAME, _cleanup),
+                            CONCAT(BENCH_NAME, _teardown)};
@@ -0,0 +1,195 @@
+#define BENCH_NAME pointer_chase
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "benchmark.h"
+#include "socket_memory.h"
+#include "util.h"
+#include "timing.h"
+
+#define CONCAT(a, b) a##b
+#define STRINGIFY(x) #x
+#define EXPAND_AND_STRINGIFY(x) STRINGIFY(x)
+
+// Dependent loads through lines homed at one CHA. The lines are shuffled
+// into `chains` disjoint random cycles, one pointer per line; the ROI walks
+// all chains interleaved, so one chain gives the load-to-use latency per hop
+// and more chains show how much memory-level parallelism the path sustains.
+//
+// Parameters: cha (default 1), home socket of the lines (default 0), req
+// socket of the chasing core (default 0), chains (1..8, default 1), hops per
+// chain (default one pass over the chain), state of the lines before the
+// ROI (memory: flushed, llc: pushed out of the private caches; default
+// memory), seed of the shuffle (default 1).
+// --sweep chains=1:8 gives the MLP curve; home=0 vs home=1 local vs remote.
+
+#define MAX_CHAINS 8
+
+typedef struct {
+  int cha;
+  int home;
+  int req;
+  int chains;
+  int llc;
+  uint64_t seed;
+  uint32_t lines;
+  uint64_t hops;
+  const pool_list_t* list;
+  uint32_t* order;  // Shuffled lines, split into the chains
+  void* heads[MAX_CHAINS];
+} state_t;
+
+static state_t state;
+
+// Every line stores the address of the next line of its chain
+static void build_chains(state_t* st) {
+  const uint32_t* order = st->order;
+  // Chain c takes every chains-th line of the shuffled order
+  for (int c = 0; c < st->chains; c++) {
+    st->heads[c] = pool_line(st->list, order[c]);
+    uint32_t prev = order[c];
+    for (uint32_t i = c + st->chains; i < st->lines; i += st->chains) {
+      *(void**)pool_line(st->list, prev) = pool_line(st->list, order[i]);
+      prev = order[i];
+    }
+    *(void**)pool_line(st->list, prev) = st->heads[c];
+  }
+}
+
+// One asm loop per chain count keeps the pointers in registers, so a hop
+// costs exactly one dependent load
+#define HOP(i) "mov (%" #i "), %" #i "\n\t"
+
+static void chase(void** p, int chains, uint64_t n) {
+  switch (chains) {
+    case 1:
+      asm volatile("1:\n\t" HOP(0) "dec %1\n\tjnz 1b" : "+r"(p[0]), "+r"(n) :: "memory");
+      break;
+    case 2:
+      asm volatile("1:\n\t" HOP(0) HOP(1) "dec %2\n\tjnz 1b" : "+r"(p[0]), "+r"(p[1]), "+r"(n) :: "memory");
+      break;
+    case 3:
+      asm volatile("1:\n\t" HOP(0) HOP(1) HOP(2) "dec %3\n\tjnz 1b"
+                   : "+r"(p[0]), "+r"(p[1]), "+r"(p[2]), "+r"(n) :: "memory");
+      break;
+    case 4:
+      asm volatile("1:\n\t" HOP(0) HOP(1) HOP(2) HOP(3) "dec %4\n\tjnz 1b"
+                   : "+r"(p[0]), "+r"(p[1]), "+r"(p[2]), "+r"(p[3]), "+r"(n) :: "memory");
+      break;
+    case 5:
+      asm volatile("1:\n\t" HOP(0) HOP(1) HOP(2) HOP(3) HOP(4) "dec %5\n\tjnz 1b"
+                   : "+r"(p[0]), "+r"(p[1]), "+r"(p[2]), "+r"(p[3]), "+r"(p[4]), "+r"(n) :: "memory");
+      break;
+    case 6:
+      asm volatile("1:\n\t" HOP(0) HOP(1) HOP(2) HOP(3) HOP(4) HOP(5) "dec %6\n\tjnz 1b"
+                   : "+r"(p[0]), "+r"(p[1]), "+r"(p[2]), "+r"(p[3]), "+r"(p[4]), "+r"(p[5]), "+r"(n)
+                   :: "memory");
+      break;
+    case 7:
+      asm volatile("1:\n\t" HOP(0) HOP(1) HOP(2) HOP(3) HOP(4) HOP(5) HOP(6) "dec %7\n\tjnz 1b"
+                   : "+r"(p[0]), "+r"(p[1]), "+r"(p[2]), "+r"(p[3]), "+r"(p[4]), "+r"(p[5]), "+r"(p[6]),
+                     "+r"(n) :: "memory");
+      break;
+    default:
+      asm volatile("1:\n\t" HOP(0) HOP(1) HOP(2) HOP(3) HOP(4) HOP(5) HOP(6) HOP(7) "dec %8\n\tjnz 1b"
+                   : "+r"(p[0]), "+r"(p[1]), "+r"(p[2]), "+r"(p[3]), "+r"(p[4]), "+r"(p[5]), "+r"(p[6]),
+                     "+r"(p[7]), "+r"(n) :: "memory");
+      break;
+  }
+}
+
+int CONCAT(BENCH_NAME, _setup)(bench_ctx_t* ctx) {
+  state.cha = bench_param_long(ctx, "cha", 1);
+  if (state.cha < 0 || state.cha >= ctx->num_chas) {
+    fprintf(stderr, "%s: no CHA %d\n", EXPAND_AND_STRINGIFY(BENCH_NAME), state.cha);
+    return -1;
+  }
+  state.chains = bench_param_long(ctx, "chains", 1);
+  if (state.chains < 1 || state.chains > MAX_CHAINS) {
+    fprintf(stderr, "%s: chains must be in [1, %d]\n", EXPAND_AND_STRINGIFY(BENCH_NAME), MAX_CHAINS);
+    return -1;
+  }
+
+  state.home = bench_param_socket(ctx, "home", 0);
+  state.req = bench_param_socket(ctx, "req", 0);
+  if (state.home < 0 || state.req < 0) return -1;
+  state.llc = strcmp(bench_param(ctx, "state", "memory"), "llc") == 0;
+  state.seed = bench_param_long(ctx, "seed", 1);
+  state.list = pool_list(ctx->pool, state.home, state.cha);
+  if (!state.list || state.list->count < (uint32_t)state.chains) return -1;
+
+  // Whole chains of equal length
+  state.lines = state.list->count - state.list->count % state.chains;
+  uint64_t length = state.lines / state.chains;
+  free(state.order);
+  state.order = bench_shuffled_order(state.lines, state.seed);
+  if (!state.order) return -1;
+  state.hops = bench_param_long(ctx, "hops", length);
+  if (state.hops == 0) state.hops = length;
+  if (state.hops > length) {
+    printf("%s: %lu hops revisit lines of a %lu-line chain\n", EXPAND_AND_STRINGIFY(BENCH_NAME), state.hops,
+           length);
+  }
+
+  ctx->priv = &state;
+  return 0;
+}
+
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  set_process_affinity(ctx->primary_cores[st->req]);
+  build_chains(st);
+
+  for (uint32_t addr = 0; addr < st->lines; addr++) {
+    flush(pool_line(st->list, addr));
+  }
+  mfence();
+  if (st->llc) {
+    for (uint32_t addr = 0; addr < st->lines; addr++) {
+      maccess(pool_line(st->list, addr));
+    }
+    evict_private_caches();
+  }
+}
+
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  void* p[MAX_CHAINS];
+  memcpy(p, st->heads, sizeof(p));
+
+  uint64_t start = timing_begin(TIMING_RDTSCP);
+  chase(p, st->chains, st->hops);
+  uint64_t end = timing_end(TIMING_RDTSCP);
+
+  // hop_latency is per load over all chains; round_latency per round of one
+  // hop on every chain, what each load waited for with the others in flight
+  double cycles = end - start - timing_overhead[TIMING_RDTSCP];
+  double total_hops = (double)st->chains * st->hops;
+  bench_report(ctx, "hop_latency", cycles / total_hops, "cycles");
+  bench_report(ctx, "round_latency", cycles / st->hops, "cycles");
+  if (tsc_ghz > 0) {
+    bench_report(ctx, "hop_latency_ns", cycles / total_hops / tsc_ghz, "ns");
+    bench_report(ctx, "round_latency_ns", cycles / st->hops / tsc_ghz, "ns");
+    bench_report(ctx, "bandwidth", total_hops * CACHE_LINE_SIZE / (cycles / tsc_ghz), "GB/s");
+  }
+}
+
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  for (uint32_t addr = 0; addr < st->lines; addr++) {
+    flush(pool_line(st->list, addr));
+  }
+  mfence();
+}
+
+void CONCAT(BENCH_NAME, _teardown)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  free(st->order);
+  st->order = NULL;
+}
+
+BenchmarkV2 benchmark_v2 = {BENCHMARK_ABI_VERSION, EXPAND_AND_STRINGIFY(BENCH_NAME),
+                            CONCAT(BENCH_NAME, _setup), CONCAT(BENCH_NAME, _init),
+                            CONCAT(BENCH_NAME, _roi), CONCAT(BENCH_NAME, _cleanup),
+                            CONCAT(BENCH_NAME, _teardown)};
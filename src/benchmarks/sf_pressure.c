@@ -0,0 +1,165 @@
+#define BENCH_NAME sf_pressure
+
+#include <stdio.h>
+#include <string.h>
+#include "benchmark.h"
+#include "socket_memory.h"
+#include "util.h"
+#include "actor.h"
+#include "timing.h"
+
+#define CONCAT(a, b) a##b
+#define STRINGIFY(x) #x
+#define EXPAND_AND_STRINGIFY(x) STRINGIFY(x)
+
+// Snoop-filter pressure at one CHA. The victim (primary core of the req
+// socket) reads its lines homed at the CHA before the window, so they sit in
+// its L2 and in the CHA's snoop filter. In the window the aggressors, other
+// physical cores of the socket, fill their L2s with more lines of the same
+// CHA; once the footprint passes the SF capacity the CHA evicts entries and
+// back-invalidates the cores holding them. The victim then re-reads its
+// lines, timed: accesses that went from an L2 hit to an LLC or memory access
+// are the back-invalidated ones.
+//
+// Parameters: cha (default 1), home socket of the lines (default 0), req
+// socket of the cores (default 0), participants including the victim
+// (default 2) or cores (colon-separated aggressor list; cores on the
+// victim's physical core are dropped), lines per
+// aggressor (default an equal share of the CHA's lines), victim_lines
+// (default lines), op of the aggressors (read or write, default read),
+// miss_threshold in cycles above which a victim access counts as a miss
+// (default 40).
+// Sweep lines and participants for footprint per CHA and per core count;
+// pair with the SF_EVICTION and CORE_SNP.EVICT_* events (SKX/CLX/ICX; SPR
+// has no SF_EVICTION). The footprint must fit the CHA's pool list:
+// sweeps/sf_pressure_footprint.json goes up to 1024 + 7 x 8192 lines and
+// needs --lines-per-cha 65536.
+
+#define MAX_AGGRESSORS (MAX_ACTORS - 1)
+
+typedef struct {
+  int cha;
+  int home;
+  int req;
+  actor_op_t op;
+  uint32_t lines;
+  uint32_t victim_lines;
+  uint32_t miss_threshold;
+  const pool_list_t* list;
+  actor_t* victim;
+  actor_t* aggressors[MAX_AGGRESSORS];
+  int num_aggressors;
+} state_t;
+
+static state_t state;
+static timing_buffer_t* victim_latency = NULL;
+
+// The victim's lines come first, then one slice per aggressor
+static uint32_t footprint(const state_t* st) {
+  return st->victim_lines + st->lines * st->num_aggressors;
+}
+
+static void flush_lines(const state_t* st) {
+  for (uint32_t addr = 0; addr < footprint(st); addr++) {
+    flush(pool_line(st->list, addr));
+  }
+  mfence();
+}
+
+int CONCAT(BENCH_NAME, _setup)(bench_ctx_t* ctx) {
+  state.cha = bench_param_long(ctx, "cha", 1);
+  if (state.cha < 0 || state.cha >= ctx->num_chas) {
+    fprintf(stderr, "%s: no CHA %d\n", EXPAND_AND_STRINGIFY(BENCH_NAME), state.cha);
+    return -1;
+  }
+  state.home = bench_param_socket(ctx, "home", 0);
+  state.req = bench_param_socket(ctx, "req", 0);
+  if (state.home < 0 || state.req < 0) return -1;
+  state.op = strcmp(bench_param(ctx, "op", "read"), "write") == 0 ? ACTOR_WRITE : ACTOR_READ;
+  state.miss_threshold = bench_param_long(ctx, "miss_threshold", 40);
+  state.list = pool_list(ctx->pool, state.home, state.cha);
+  if (!state.list || state.list->count < 2) return -1;
+
+  int cores[MAX_AGGRESSORS];
+  state.num_aggressors = bench_param_cores(ctx, "cores", state.req, bench_param_long(ctx, "participants", 2) - 1,
+                                           ctx->primary_cores[state.req], cores, MAX_AGGRESSORS);
+  if (state.num_aggressors < 1) {
+    fprintf(stderr, "%s: not enough aggressor cores on socket %d\n", EXPAND_AND_STRINGIFY(BENCH_NAME), state.req);
+    return -1;
+  }
+
+  uint32_t share = state.list->count / (state.num_aggressors + 1);
+  state.lines = bench_param_long(ctx, "lines", share);
+  state.victim_lines = bench_param_long(ctx, "victim_lines", state.lines);
+  if (state.lines == 0 || state.victim_lines == 0 || footprint(&state) > state.list->count) {
+    fprintf(stderr, "%s: %u victim and %d x %u aggressor lines exceed the %u lines of CHA %d; raise --lines-per-cha\n",
+            EXPAND_AND_STRINGIFY(BENCH_NAME), state.victim_lines, state.num_aggressors, state.lines,
+            state.list->count, state.cha);
+    return -1;
+  }
+
+  state.victim = bench_actor(ctx, state.req, 0);
+  if (!state.victim) return -1;
+  for (int a = 0; a < state.num_aggressors; a++) {
+    state.aggressors[a] = actor_get(cores[a]);
+    if (!state.aggressors[a]) return -1;
+  }
+  if (!victim_latency) {
+    victim_latency = timing_buffer_create(EXPAND_AND_STRINGIFY(BENCH_NAME) " victim", TIMING_RDTSCP,
+                                          pool_lines_per_cha);
+    if (victim_latency) timing_buffer_histograms(victim_latency);
+  }
+  printf("%s: victim core %d, %d aggressors, footprint %u lines (%u KiB) at CHA %d\n",
+         EXPAND_AND_STRINGIFY(BENCH_NAME), state.victim->core_id, state.num_aggressors, footprint(&state),
+         footprint(&state) * CACHE_LINE_SIZE / 1024, state.cha);
+
+  ctx->priv = &state;
+  return 0;
+}
+
+// Everything flushed, then the victim's lines into its L2
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  flush_lines(st);
+  actor_submit(st->victim, ACTOR_READ, st->list, 0, st->victim_lines);
+  actor_sync(st->victim);
+}
+
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
+  state_t* st = ctx->priv;
+  for (int a = 0; a < st->num_aggressors; a++) {
+    actor_submit(st->aggressors[a], st->op, st->list, st->victim_lines + a * st->lines, st->lines);
+  }
+
+  // The victim re-reads once every aggressor is done
+  uint32_t first = victim_latency ? victim_latency->count : 0;
+  for (int a = 0; a < st->num_aggressors; a++) {
+    actor_after(st->victim, st->aggressors[a]);
+  }
+  actor_submit_timed(st->victim, ACTOR_READ, st->list, 0, st->victim_lines, victim_latency,
+                     TIMING_KEY(st->req, st->home, st->cha, 0));
+  actor_sync(st->victim);
+  for (int a = 0; a < st->num_aggressors; a++) {
+    actor_sync(st->aggressors[a]);
+  }
+
+  // Samples are still in the buffer until the driver flushes it
+  if (!victim_latency || victim_latency->count == first) return;
+  uint64_t sum = 0;
+  uint32_t misses = 0;
+  for (uint32_t i = first; i < victim_latency->count; i++) {
+    sum += victim_latency->samples[i].cycles;
+    misses += victim_latency->samples[i].cycles > st->miss_threshold;
+  }
+  uint32_t count = victim_latency->count - first;
+  bench_report(ctx, "victim_latency", (double)sum / count, "cycles");
+  bench_report(ctx, "victim_misses", 100.0 * misses / count, "%");
+}
+
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
+  flush_lines(ctx->priv);
+}
+
+BenchmarkV2 benchmark_v2 = {BENCHMARK_ABI_VERSION, EXPAND_AND_STRINGIFY(BENCH_NAME),
+                            CONCAT(BENCH_NAME, _setup), CONCAT(BENCH_NAME, _init),
+                            CONCAT(BENCH_NAME, _roi), CONCAT(BENCH_NAME, _cleanup), NULL};
@@ -0,0 +1,64 @@
+#define BENCH_NAME slice_conflict
+
+#include <stdio.h>
+#include "socket_memory.h"
+#include "benchmark.h"
+#include "evset.h"
+#include "util.h"
+
+#define CONCAT(a, b) a##b
+#define STRINGIFY(x) #x
+#define EXPAND_AND_STRINGIFY(x) STRINGIFY(x)
+
+// LLC conflict pressure on one set of one slice. Needs an eviction set built
+// before monitoring, e.g. --evset 0:13:0. The target is made LLC resident,
+// the eviction set is traversed in the ROI and the target is timed afterwards.
+
+static const evset_t* evset = NULL;
+static uint64_t target_cycles = 0;
+static int evictions = 0;
+static int runs = 0;
+
+void CONCAT(BENCH_NAME, _init)(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+    if (!evset) {
+        if (num_evsets == 0) {
+            fprintf(stderr, "%s: no eviction set, run with --evset socket:cha:set\n", EXPAND_AND_STRINGIFY(BENCH_NAME));
+            return;
+        }
+        evset = &evsets[0];
+    }
+
+    set_process_affinity(primary_cores[0]);
+    maccess(evset->target);
+    mfence();
+    evict_private_caches();
+}
+
+void CONCAT(BENCH_NAME, _roi)(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+    if (!evset) return;
+
+    evset_traverse(evset);
+    evict_private_caches();
+
+    uint64_t start = rdtsc();
+    maccess(evset->target);
+    uint64_t end = rdtsc();
+
+    target_cycles += end - start;
+    evictions += end - start > evset->threshold;
+    runs++;
+}
+
+void CONCAT(BENCH_NAME, _cleanup)(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+    if (!evset || runs == 0) return;
+    printf("%s: socket %d, CHA %d, set %d, %d lines: target evicted in %d/%d runs, %.1f cycles/access\n",
+           EXPAND_AND_STRINGIFY(BENCH_NAME), evset->socket_id, evset->cha, evset->set, evset->count,
+           evictions, runs, (double)target_cycles / runs);
+}
+
+Benchmark benchmark = {
+    EXPAND_AND_STRINGIFY(BENCH_NAME),
+    CONCAT(BENCH_NAME, _init),
+    CONCAT(BENCH_NAME, _roi),
+    CONCAT(BENCH_NAME, _cleanup)
+};
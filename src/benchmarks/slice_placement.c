@@ -0,0 +1,97 @@
+#define BENCH_NAME slice_placement
+
+#include <stdio.h>
+#include "socket_memory.h"
+#include "benchmark.h"
+#include "slice_alloc.h"
+#include "util.h"
+
+#define CONCAT(a, b) a##b
+#define STRINGIFY(x) #x
+#define EXPAND_AND_STRINGIFY(x) STRINGIFY(x)
+
+// LLC hit latency of per-core objects: lines from the slice allocator homed at
+// the CHA nearest to the measuring core vs. consecutive lines from
+// numa_alloc_onnode on the same socket.
+
+#define HOME_SOCKET 0
+#define NUM_OBJECTS 32
+
+static void* slice_objects[NUM_OBJECTS];
+static void* numa_objects[NUM_OBJECTS];
+static uint8_t* numa_region = NULL;
+static int num_slice_objects = 0;
+static uint64_t slice_cycles = 0;
+static uint64_t numa_cycles = 0;
+
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
+    if (!numa_region) {
+        slice_alloc_init(ctx->pool, HOME_SOCKET);
+        for (int i = 0; i < NUM_OBJECTS; i++) {
+            slice_objects[num_slice_objects] = slice_alloc_near_core(HOME_SOCKET, ctx->primary_cores[HOME_SOCKET]);
+            if (slice_objects[num_slice_objects]) num_slice_objects++;
+        }
+        printf("%s: nearest CHA to core %d is %d (%d objects)\n", EXPAND_AND_STRINGIFY(BENCH_NAME),
+               ctx->primary_cores[HOME_SOCKET], slice_nearest_cha(HOME_SOCKET, ctx->primary_cores[HOME_SOCKET]),
+               num_slice_objects);
+
+        numa_region = numa_alloc_onnode(NUM_OBJECTS * CACHE_LINE_SIZE, HOME_SOCKET);
+        if (!numa_region) {
+            fprintf(stderr, "%s: numa_alloc_onnode failed\n", EXPAND_AND_STRINGIFY(BENCH_NAME));
+            return;
+        }
+        for (int i = 0; i < NUM_OBJECTS; i++) {
+            numa_objects[i] = numa_region + i * CACHE_LINE_SIZE;
+            mmodify(numa_objects[i]);
+        }
+    }
+
+    // Make both object sets LLC resident for the measuring core
+    set_process_affinity(ctx->primary_cores[HOME_SOCKET]);
+    for (int i = 0; i < num_slice_objects; i++) {
+        maccess(slice_objects[i]);
+    }
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        maccess(numa_objects[i]);
+    }
+    mfence();
+    evict_private_caches();
+}
+
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
+    uint64_t start, end;
+
+    slice_cycles = 0;
+    for (int i = 0; i < num_slice_objects; i++) {
+        start = rdtsc();
+        maccess(slice_objects[i]);
+        end = rdtsc();
+        slice_cycles += end - start;
+    }
+
+    numa_cycles = 0;
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        start = rdtsc();
+        maccess(numa_objects[i]);
+        end = rdtsc();
+        numa_cycles += end - start;
+    }
+}
+
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
+    if (num_slice_objects > 0) {
+        printf("%s: slice_alloc %.1f cycles/access, numa_alloc_onnode %.1f cycles/access\n",
+               EXPAND_AND_STRINGIFY(BENCH_NAME), (double)slice_cycles / num_slice_objects,
+               (double)numa_cycles / NUM_OBJECTS);
+    }
+}
+
+BenchmarkV2 benchmark_v2 = {
+    BENCHMARK_ABI_VERSION,
+    EXPAND_AND_STRINGIFY(BENCH_NAME),
+    NULL,
+    CONCAT(BENCH_NAME, _init),
+    CONCAT(BENCH_NAME, _roi),
+    CONCAT(BENCH_NAME, _cleanup),
+    NULL
+};
@@ -0,0 +1,84 @@
+#define BENCH_NAME snc_locality
+
+#include <stdio.h>
+#include "socket_memory.h"
+#include "benchmark.h"
+#include "topology.h"
+#include "util.h"
+
+#define CONCAT(a, b) a##b
+#define STRINGIFY(x) #x
+#define EXPAND_AND_STRINGIFY(x) STRINGIFY(x)
+
+// Memory read latency from primary core of socket 0 to lines of the local SNC
+// node, another SNC node of the same socket, and a remote socket.
+
+#define NUM_LOCALITIES 3
+
+static uint64_t cycles[NUM_LOCALITIES];
+static int lines[NUM_LOCALITIES];
+
+void CONCAT(BENCH_NAME, _init)(bench_ctx_t* ctx) {
+    addr_pool_t* pool = ctx->pool;
+
+    for (int loc = 0; loc < NUM_LOCALITIES; loc++) {
+        int socket_id, chas[NUM_CHA];
+        int n = get_locality_chas(ctx->primary_cores[0], loc, &socket_id, chas);
+        for (int i = 0; i < n; i++) {
+            const pool_list_t* list = pool_list(pool, socket_id, chas[i]);
+            for (uint32_t addr = 0; addr < list->count; addr++) {
+                void* target = pool_line(list, addr);
+                flush(target);
+                mfence();
+            }
+        }
+    }
+
+    set_process_affinity(ctx->primary_cores[0]);
+}
+
+void CONCAT(BENCH_NAME, _roi)(bench_ctx_t* ctx) {
+    addr_pool_t* pool = ctx->pool;
+    uint64_t start, end;
+
+    for (int loc = 0; loc < NUM_LOCALITIES; loc++) {
+        int socket_id, chas[NUM_CHA];
+        int n = get_locality_chas(ctx->primary_cores[0], loc, &socket_id, chas);
+
+        cycles[loc] = 0;
+        lines[loc] = 0;
+        for (int i = 0; i < n; i++) {
+            const pool_list_t* list = pool_list(pool, socket_id, chas[i]);
+            for (uint32_t addr = 0; addr < list->count; addr++) {
+                void* target = pool_line(list, addr);
+                start = rdtsc();
+                maccess(target);
+                end = rdtsc();
+                cycles[loc] += end - start;
+                lines[loc]++;
+            }
+        }
+    }
+}
+
+void CONCAT(BENCH_NAME, _cleanup)(bench_ctx_t* ctx) {
+    for (int loc = 0; loc < NUM_LOCALITIES; loc++) {
+        if (lines[loc] == 0) {
+            printf("%s: %-22s no lines (SNC disabled or socket absent)\n",
+                   EXPAND_AND_STRINGIFY(BENCH_NAME), locality_name(loc));
+            continue;
+        }
+        printf("%s: %-22s %6d lines, %.1f cycles/access\n", EXPAND_AND_STRINGIFY(BENCH_NAME),
+               locality_name(loc), lines[loc], (double)cycles[loc] / lines[loc]);
+    }
+}
+
+BenchmarkV2 benchmark_v2 = {
+    BENCHMARK_ABI_VERSION,
+    EXPAND_AND_STRINGIFY(BENCH_NAME),
+    NULL,
+    CONCAT(BENCH_NAME, _init),
+    CONCAT(BENCH_NAME, _roi),
+    CONCAT(BENCH_NAME, _cleanup),
+    NULL
+};
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "curve.h"
+#include "msr_defs.h"
+
+// Curves a benchmark builds across parameter sets (a sweep, a server
+// session) are kept as one line per point in CURVE_DIR/<name>_points.log:
+// "key<TAB>x<TAB>y0<TAB>y1". Reports are rebuilt from the whole file, so
+// points a resumed sweep skips still count. A later line for the same key
+// and x replaces the earlier one; delete the file to start over.
+
+static void points_path(const char *name, char *path, size_t size) {
+    snprintf(path, size, "%s/%s_points.log", CURVE_DIR, name);
+}
+
+// Append a point, on disk before the next parameter set starts
+int curve_add_point(const char *name, const char *key, const curve_point_t *point) {
+    char path[512];
+    if (strchr(key, '\t') || strchr(key, '\n')) return -1;
+    if (create_directory_recursively(CURVE_DIR) != 0) return -1;
+    points_path(name, path, sizeof(path));
+
+    FILE *fp = fopen(path, "a");
+    if (!fp) {
+        perror("Error opening curve points");
+        return -1;
+    }
+    fprintf(fp, "%s\t%.17g", key, point->x);
+    for (int i = 0; i < CURVE_VALUES; i++) fprintf(fp, "\t%.17g", point->y[i]);
+    fprintf(fp, "\n");
+    fflush(fp);
+    fsync(fileno(fp));
+    fclose(fp);
+    return 0;
+}
+
+static int compare_x(const void *a, const void *b) {
+    double diff = ((const curve_point_t *)a)->x - ((const curve_point_t *)b)->x;
+    return (diff > 0) - (diff < 0);
+}
+
+// Every curve recorded under name, points sorted by x. Returns how many.
+int curve_load(const char *name, curve_t *curves, int max_curves) {
+    char path[512], line[CURVE_KEY_LEN + 128];
+    points_path(name, path, sizeof(path));
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+
+    int num_curves = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        char *tab = strchr(line, '\t');
+        if (!tab || tab - line >= CURVE_KEY_LEN) continue;
+        *tab = '\0';
+
+        curve_point_t point = {0};
+        char *end;
+        point.x = strtod(tab + 1, &end);
+        for (int i = 0; i < CURVE_VALUES && *end == '\t'; i++) point.y[i] = strtod(end + 1, &end);
+
+        curve_t *curve = NULL;
+        for (int c = 0; c < num_curves && !curve; c++) {
+            if (strcmp(curves[c].key, line) == 0) curve = &curves[c];
+        }
+        if (!curve) {
+            if (num_curves >= max_curves) continue;
+            curve = &curves[num_curves++];
+            memset(curve, 0, sizeof(*curve));
+            memcpy(curve->key, line, tab - line + 1);
+        }
+
+        int i = 0;
+        while (i < curve->num_points && curve->points[i].x != point.x) i++;
+        if (i == MAX_CURVE_POINTS) continue;
+        if (i == curve->num_points) curve->num_points++;
+        curve->points[i] = point;
+    }
+    fclose(fp);
+
+    for (int c = 0; c < num_curves; c++) {
+        qsort(curves[c].points, curves[c].num_points, sizeof(curve_point_t), compare_x);
+    }
+    return num_curves;
+}
@@ -0,0 +1,371 @@
+#include <string.h>
+#include "evset.h"
+#include "topology.h"
+
+evset_t evsets[EVSET_MAX_PRESETS];
+int num_evsets = 0;
+
+// L3 slice set of a line, from its physical address when pagemap allows
+int l3_slice_set(void *addr) {
+    uint64_t phys = virt_to_phys(addr);
+    if (!phys) phys = (uintptr_t)addr;  // Only exact within a hugepage
+    return (phys & L3_SLICE_SET_INDEX_MASK) >> 6;
+}
+
+static uint64_t median(uint64_t *v, int n) {
+    for (int i = 1; i < n; i++) {
+        uint64_t x = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > x) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = x;
+    }
+    return v[n / 2];
+}
+
+static uint64_t time_access(void *p) {
+    uint64_t start = rdtsc();
+    maccess(p);
+    uint64_t end = rdtsc();
+    return end - start;
+}
+
+// Threshold between an LLC hit (target pushed out of L1/L2 only) and a memory
+// access (target flushed) for the calling core
+uint64_t evset_calibrate(void *target) {
+    uint64_t hit[EVSET_CALIBRATION_REPS], miss[EVSET_CALIBRATION_REPS];
+
+    for (int rep = 0; rep < EVSET_CALIBRATION_REPS; rep++) {
+        maccess(target);
+        evict_private_caches();
+        hit[rep] = time_access(target);
+
+        flush(target);
+        mfence();
+        miss[rep] = time_access(target);
+    }
+
+    uint64_t hit_cycles = median(hit, EVSET_CALIBRATION_REPS);
+    uint64_t miss_cycles = median(miss, EVSET_CALIBRATION_REPS);
+    DEBUG_PRINT("Eviction set calibration: LLC hit %lu, miss %lu cycles", hit_cycles, miss_cycles);
+    return (hit_cycles + miss_cycles) / 2;
+}
+
+void evset_traverse(const evset_t *evset) {
+    for (int pass = 0; pass < EVSET_PASSES; pass++) {
+        for (int i = 0; i < evset->count; i++) {
+            maccess(evset->lines[i]);
+        }
+    }
+    mfence();
+}
+
+// LLC is non-inclusive: lines reach it as L2 victims, so both the target and
+// the set are pushed out of the private caches before the target is timed.
+static int evicts_once(const evset_t *evset, void *target) {
+    maccess(target);
+    mfence();
+    evict_private_caches();
+
+    evset_traverse(evset);
+    evict_private_caches();
+
+    return time_access(target) > evset->threshold;
+}
+
+// 1 if traversing the set evicts target from the LLC in most trials
+int evset_evicts(const evset_t *evset, void *target) {
+    int evicted = 0;
+    for (int trial = 0; trial < EVSET_TRIALS; trial++) {
+        evicted += evicts_once(evset, target);
+    }
+    return evicted > EVSET_TRIALS / 2;
+}
+
+static int contains(const evset_t *evset, void *line) {
+    if (line == evset->target) return 1;
+    for (int i = 0; i < evset->count; i++) {
+        if (evset->lines[i] == line) return 1;
+    }
+    return 0;
+}
+
+static void add_candidate(evset_t *evset, void *line) {
+    if (!evset->target) {
+        evset->target = line;
+    } else {
+        evset->lines[evset->count++] = line;
+    }
+}
+
+static int collect_candidates(evset_t *evset, const addr_pool_t *pool,
+                              int* msr_fds, int num_sockets, cha_event_t* events, int num_events) {
+    const pool_list_t *list = pool_list(pool, evset->socket_id, evset->cha);
+
+    // Pool lines are sorted by the virtual set index, which matches the
+    // physical one for hugepage-backed buffers; anything else is re-checked.
+    uint32_t first, n = pool_set_range(pool, evset->socket_id, evset->cha, evset->set, &first);
+    for (uint32_t i = 0; i < n && evset->count < EVSET_MAX_LINES; i++) {
+        void *line = pool_line(list, first + i);
+        if (l3_slice_set(line) == evset->set) add_candidate(evset, line);
+    }
+
+    if (!msr_fds || evset->count >= EVSET_MAX_LINES) return evset->count;
+
+    int node = list->count ? list->node : cha_node[evset->socket_id][evset->cha];
+    uint8_t *buffer = node >= 0 ? node_buffers[node] : NULL;
+    if (!buffer) {
+        fprintf(stderr, "Error: CHA %d of socket %d has no mapped node buffer\n", evset->cha, evset->socket_id);
+        return evset->count;
+    }
+
+    // Bits [11:6] of the set index are the page offset; the rest is checked
+    // per page against the physical address
+    size_t in_page = ((size_t)evset->set << 6) & (PAGE_SIZE - 1);
+    int probed = 0;
+    for (size_t off = in_page; off < BUFFER_SIZE && evset->count < EVSET_MAX_LINES; off += PAGE_SIZE) {
+        void *line = buffer + off;
+        if (l3_slice_set(line) != evset->set || contains(evset, line)) continue;
+
+        if (probed++ >= EVSET_SCAN_LIMIT) break;
+        if (find_cha_mapped_offset(line, msr_fds, num_sockets, events, num_events) == evset->cha) {
+            add_candidate(evset, line);
+        }
+        display_progress("Eviction set: ", evset->count, EVSET_MAX_LINES);
+    }
+    printf("\n");
+    return evset->count;
+}
+
+// Group-test reduction: split the set into L3_ASSOC + 1 groups and drop any
+// group without which the target is still evicted.
+static void reduce(evset_t *evset) {
+    evset_t trial = *evset;
+
+    while (evset->count > L3_ASSOC) {
+        int groups = L3_ASSOC + 1;
+        int removed = 0;
+
+        for (int g = 0; g < groups && !removed; g++) {
+            int lo = evset->count * g / groups;
+            int hi = evset->count * (g + 1) / groups;
+            if (lo == hi) continue;
+
+            trial.count = 0;
+            for (int i = 0; i < evset->count; i++) {
+                if (i < lo || i >= hi) trial.lines[trial.count++] = evset->lines[i];
+            }
+            if (evset_evicts(&trial, evset->target)) {
+                memcpy(evset->lines, trial.lines, trial.count * sizeof(void *));
+                evset->count = trial.count;
+                removed = 1;
+            }
+        }
+
+        if (!removed) break;  // Replacement policy needs more than L3_ASSOC lines
+    }
+}
+
+// Build an eviction set for (socket, CHA, L3 set). Returns its size, or -1 if
+// not enough congruent lines were found or they do not evict the target.
+int evset_build(evset_t *evset, const addr_pool_t *pool, int socket_id, int cha, int set,
+                int* msr_fds, int num_sockets, cha_event_t* events, int num_events) {
+    if (socket_id < 0 || socket_id >= pool->num_sockets || cha < 0 || cha >= NUM_CHA ||
+        set < 0 || set >= L3_SLICE_SETS) {
+        fprintf(stderr, "Error: invalid eviction set target (socket %d, CHA %d, set %d)\n", socket_id, cha, set);
+        return -1;
+    }
+
+    memset(evset, 0, sizeof(*evset));
+    evset->socket_id = socket_id;
+    evset->cha = cha;
+    evset->set = set;
+
+    collect_candidates(evset, pool, msr_fds, num_sockets, events, num_events);
+    if (!evset->target || evset->count < L3_ASSOC) {
+        fprintf(stderr, "Error: only %d lines of CHA %d (socket %d) map to set %d\n",
+                evset->count + (evset->target != NULL), cha, socket_id, set);
+        return -1;
+    }
+
+    evset->threshold = evset_calibrate(evset->target);
+    if (!evset_evicts(evset, evset->target)) {
+        fprintf(stderr, "Error: %d congruent lines do not evict set %d of CHA %d (socket %d)\n",
+                evset->count, set, cha, socket_id);
+        return -1;
+    }
+
+    reduce(evset);
+    if (evset->count > L3_ASSOC) {
+        printf("Eviction set for CHA %d, set %d needs %d lines (associativity %d)\n",
+               cha, set, evset->count, L3_ASSOC);
+    }
+    return evset->count;
+}
+
+const evset_t *evset_lookup(int socket_id, int cha, int set) {
+    for (int i = 0; i < num_evsets; i++) {
+        if (evsets[i].socket_id == socket_id && evsets[i].cha == cha && evsets[i].set == set) {
+            return &evsets[i];
+        }
+    }
+    return NULL;
+}
+
+// Scratch lines for private eviction sets, touched once so they are mapped
+static uint8_t *private_scratch(void) {
+    static uint8_t *scratch = NULL;
+    if (scratch) return scratch;
+
+    void *mem = mmap(NULL, PRIVATE_SCRATCH_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+    madvise(mem, PRIVATE_SCRATCH_SIZE, MADV_HUGEPAGE);
+    memset(mem, 0, PRIVATE_SCRATCH_SIZE);
+    scratch = mem;
+    return scratch;
+}
+
+// Collect scratch lines in the target's L1 and L2 sets (physical index) that
+// fall in a different L3 slice set, so they cannot displace it from the LLC.
+int private_evset_build(private_evset_t *pe, void *target) {
+    uint8_t *scratch = private_scratch();
+    if (!scratch) return -1;
+
+    memset(pe, 0, sizeof(*pe));
+    pe->target = target;
+
+    uint64_t target_phys = virt_to_phys(target);
+    if (!target_phys) target_phys = (uintptr_t)target;
+
+    size_t in_page = (uintptr_t)target & (PAGE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+    for (size_t off = in_page; off < PRIVATE_SCRATCH_SIZE && pe->count < PRIVATE_EVSET_LINES; off += PAGE_SIZE) {
+        uint64_t phys = virt_to_phys(scratch + off);
+        if (!phys) phys = (uintptr_t)(scratch + off);
+
+        uint64_t diff = phys ^ target_phys;
+        if (diff & (L1_SET_INDEX_MASK | L2_SET_INDEX_MASK)) continue;
+        if (!(diff & L3_SLICE_SET_INDEX_MASK)) continue;
+        pe->lines[pe->count++] = scratch + off;
+    }
+
+    if (pe->count < PRIVATE_EVSET_LINES) {
+        fprintf(stderr, "Warning: only %d of %d private eviction lines for %p\n",
+                pe->count, PRIVATE_EVSET_LINES, target);
+    }
+    return pe->count > L2_ASSOC ? pe->count : -1;
+}
+
+// Evict the target from L1/L2; being a clean L2 victim it moves to the LLC
+void evict_to_llc(const private_evset_t *pe) {
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < pe->count; i++) {
+            maccess(pe->lines[i]);
+        }
+    }
+    mfence();
+}
+
+// Load the target, evict it with evict_to_llc() and read it again with the
+// lookup counters running. Returns 1 if the read was looked up and hit at the
+// given CHA, 0 if not, -1 if the counters cannot tell. Reprograms the CHA
+// counters, so it must not run inside a monitoring session.
+int verify_llc_hit(const private_evset_t *pe, int socket_id, int cha,
+                   int* msr_fds, int num_sockets, cha_event_t* events, int num_events) {
+    static uint64_t verify_counts[NUM_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS];
+#ifdef LLC_LOOKUP_MISS_EVENT
+    char *event_name_list[] = {LLC_LOOKUP_READ_EVENT, LLC_LOOKUP_MISS_EVENT};
+#else
+    char *event_name_list[] = {LLC_LOOKUP_READ_EVENT};
+#endif
+    int num_events_to_program = sizeof(event_name_list) / sizeof(event_name_list[0]);
+
+    if (socket_id < 0 || socket_id >= num_sockets || cha < 0 || cha >= NUM_CHA) return -1;
+
+    maccess(pe->target);
+    mfence();
+    evict_to_llc(pe);
+
+    freeze_counters_global(msr_fds, num_sockets);
+    configure_cha_counters(msr_fds, num_sockets, events, num_events, event_name_list, num_events_to_program);
+    unfreeze_counters_global(msr_fds, num_sockets);
+
+    maccess(pe->target);
+    mfence();
+
+    freeze_counters_global(msr_fds, num_sockets);
+    read_cha_counters(msr_fds, num_sockets, events, num_events, event_name_list, num_events_to_program,
+                      0, verify_counts, 0);
+
+    uint64_t lookups = verify_counts[0][socket_id][cha][0];
+    if (lookups == 0) return 0;  // Served from L1/L2: never left the core
+#ifdef LLC_LOOKUP_MISS_EVENT
+    return verify_counts[0][socket_id][cha][1] == 0;
+#else
+    return -1;  // No miss event on this architecture: lookup seen, hit unknown
+#endif
+}
+
+// Mesh distance proxy: the median LLC hit latency from each physical core of
+// the socket to lines homed at the CHA. The nearest two cores that are not
+// the orchestrator's become primary and secondary; ties keep the lower CPU.
+int select_cores_near_cha(const addr_pool_t *pool, int socket_id, int cha) {
+    static private_evset_t pe[NEAR_CHA_LINES];
+    int lines = 0;
+    for (uint32_t i = 0; i < pool_count(pool, socket_id, cha) && lines < NEAR_CHA_LINES; i++) {
+        if (private_evset_build(&pe[lines], pool_addr(pool, socket_id, cha, i)) > 0) lines++;
+    }
+    if (lines == 0) {
+        fprintf(stderr, "Error: no lines to time for socket %d, CHA %d\n", socket_id, cha);
+        return -1;
+    }
+
+    int best[2] = {-1, -1};
+    uint64_t best_cycles[2] = {UINT64_MAX, UINT64_MAX};
+    for (int cpu = 0; cpu < num_cpus; cpu++) {
+        const cpu_topo_t *t = &cpu_topo[cpu];
+        if (!t->online || t->package != socket_id || t->first_sibling != cpu ||
+            same_physical_core(cpu, orchestrator_cores[socket_id])) {
+            continue;
+        }
+
+        set_process_affinity(cpu);
+        uint64_t samples[NEAR_CHA_LINES * NEAR_CHA_REPS];
+        int n = 0;
+        for (int rep = 0; rep < NEAR_CHA_REPS; rep++) {
+            for (int i = 0; i < lines; i++) {
+                maccess(pe[i].target);
+                mfence();
+                evict_to_llc(&pe[i]);
+                samples[n++] = time_access(pe[i].target);
+            }
+        }
+        uint64_t cycles = median(samples, n);
+        DEBUG_PRINT("Core %d to socket %d CHA %d: %lu cycles", cpu, socket_id, cha, cycles);
+
+        if (cycles < best_cycles[0]) {
+            best[1] = best[0];
+            best_cycles[1] = best_cycles[0];
+            best[0] = cpu;
+            best_cycles[0] = cycles;
+        } else if (cycles < best_cycles[1]) {
+            best[1] = cpu;
+            best_cycles[1] = cycles;
+        }
+    }
+    set_process_affinity(orchestrator_cores[0]);
+
+    if (best[0] < 0) return -1;
+    primary_cores[socket_id] = best[0];
+    printf("Nearest core to socket %d, CHA %d: %d (%lu cycles)", socket_id, cha, best[0], best_cycles[0]);
+    if (best[1] >= 0) {
+        secondary_cores[socket_id] = best[1];
+        printf(", then %d (%lu cycles)", best[1], best_cycles[1]);
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <string.h>
+#include "histogram.h"
+#include "timing.h"
+
+// Highest value that lands in bucket idx
+static uint64_t bucket_high(uint32_t idx) {
+    if (idx < 2 * HIST_SUB_BUCKETS) return idx;
+    uint32_t shift = idx / HIST_SUB_BUCKETS - 1;
+    uint64_t sub = idx - shift * HIST_SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void hist_reset(histogram_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+void hist_merge(histogram_t *dst, const histogram_t *src) {
+    if (src->total == 0) return;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    if (dst->total == 0 || src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+    dst->total += src->total;
+}
+
+// Smallest recorded value v such that percentile% of samples are <= v, to
+// bucket precision; capped by the exact max
+uint64_t hist_percentile(const histogram_t *hist, double percentile) {
+    if (hist->total == 0) return 0;
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * hist->total + 0.5);
+    if (rank < 1) rank = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            uint64_t high = bucket_high(i);
+            return high < hist->max ? high : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+void latency_hist_merge(latency_hist_t *dst, const latency_hist_t *src) {
+    for (int req = 0; req < MAX_SOCKETS; req++) {
+        for (int home = 0; home < MAX_SOCKETS; home++) {
+            for (int cha = 0; cha < NUM_CHA; cha++) {
+                hist_merge(&dst->h[req][home][cha], &src->h[req][home][cha]);
+            }
+        }
+    }
+}
+
+// p50/p90/p99/p99.9/max of every non-empty key, in cycles
+void latency_hist_report(const latency_hist_t *lh, const char *label, FILE *out) {
+    for (int req = 0; req < MAX_SOCKETS; req++) {
+        for (int home = 0; home < MAX_SOCKETS; home++) {
+            for (int cha = 0; cha < NUM_CHA; cha++) {
+                const histogram_t *hist = &lh->h[req][home][cha];
+                if (hist->total == 0) continue;
+                uint64_t p50 = hist_percentile(hist, 50);
+                fprintf(out, "%s: S%d->S%d CHA %2d: p50 %lu (%.1f ns), p90 %lu, p99 %lu, p99.9 %lu, max %lu cycles, "
+                        "%lu samples\n", label, req, home, cha, p50, timing_ns(p50), hist_percentile(hist, 90),
+                        hist_percentile(hist, 99), hist_percentile(hist, 99.9), hist->max, hist->total);
+            }
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#include <string.h>
+#include <sys/mman.h>
+#include "jit.h"
+
+// Upper bound of the bytes emitted per access (timed, immediate, fenced)
+#define JIT_MAX_ACCESS_BYTES 64
+
+typedef struct {
+    uint8_t *code;
+    size_t len;
+} emitter_t;
+
+static void emit(emitter_t *e, const uint8_t *bytes, size_t n) {
+    memcpy(e->code + e->len, bytes, n);
+    e->len += n;
+}
+
+static void emit32(emitter_t *e, uint32_t value) { emit(e, (const uint8_t *)&value, 4); }
+static void emit64(emitter_t *e, uint64_t value) { emit(e, (const uint8_t *)&value, 8); }
+
+// rax = rdtscp (clobbers rcx, rdx)
+static void emit_tsc(emitter_t *e) {
+    static const uint8_t tsc[] = {
+        0x0F, 0x01, 0xF9,           // rdtscp
+        0x48, 0xC1, 0xE2, 0x20,     // shl rdx, 32
+        0x48, 0x09, 0xD0,           // or rax, rdx
+    };
+    emit(e, tsc, sizeof(tsc));
+}
+
+static void emit_mfence(emitter_t *e) { emit(e, (const uint8_t[]){0x0F, 0xAE, 0xF0}, 3); }
+static void emit_lfence(emitter_t *e) { emit(e, (const uint8_t[]){0x0F, 0xAE, 0xE8}, 3); }
+
+// rcx = address of access i
+static void emit_address(emitter_t *e, void *line, uint32_t i, unsigned flags) {
+    if (flags & JIT_TABLE) {
+        emit(e, (const uint8_t[]){0x48, 0x8B, 0x8F}, 3);   // mov rcx, [rdi + disp32]
+        emit32(e, i * sizeof(void *));
+    } else {
+        emit(e, (const uint8_t[]){0x48, 0xB9}, 2);         // mov rcx, imm64
+        emit64(e, (uint64_t)(uintptr_t)line);
+    }
+}
+
+// The same instructions as maccess/mmodify/flush/matomic in util.h
+static int emit_op(emitter_t *e, actor_op_t op) {
+    switch (op) {
+        case ACTOR_READ:
+            emit(e, (const uint8_t[]){0x48, 0x8B, 0x01}, 3);                        // mov rax, [rcx]
+            return 0;
+        case ACTOR_WRITE:
+            emit(e, (const uint8_t[]){0x48, 0xC7, 0x01, 0x01, 0x00, 0x00, 0x00}, 7);  // mov qword [rcx], 1
+            return 0;
+        case ACTOR_FLUSH:
+            emit(e, (const uint8_t[]){0x0F, 0xAE, 0x39}, 3);                        // clflush [rcx]
+            return 0;
+        case ACTOR_ATOMIC:
+            emit(e, (const uint8_t[]){0xF0, 0x48, 0x83, 0x01, 0x01}, 5);            // lock add qword [rcx], 1
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+// Emit a kernel performing op (or ops[i], if ops is given) on lines[i] for
+// every i, in order. Timed kernels bracket each access like rdtsc() in
+// util.c and store end - start to cycles[i].
+jit_kernel_t *jit_build(void *const *lines, const actor_op_t *ops, actor_op_t op, uint32_t count, unsigned flags) {
+    jit_kernel_t *kernel = calloc(1, sizeof(jit_kernel_t));
+    if (!kernel) {
+        perror("calloc");
+        return NULL;
+    }
+    kernel->count = count;
+    kernel->flags = flags;
+    kernel->size = ((size_t)count * JIT_MAX_ACCESS_BYTES + 16 + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+
+    kernel->code = mmap(NULL, kernel->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (kernel->code == MAP_FAILED) {
+        perror("mmap");
+        free(kernel);
+        return NULL;
+    }
+
+    if (flags & JIT_TABLE) {
+        kernel->table = malloc((count ? count : 1) * sizeof(void *));
+        if (kernel->table) memcpy(kernel->table, lines, count * sizeof(void *));
+    }
+    if (flags & JIT_TIMED) {
+        kernel->cycles = calloc(count ? count : 1, sizeof(uint64_t));
+    }
+    if (((flags & JIT_TABLE) && !kernel->table) || ((flags & JIT_TIMED) && !kernel->cycles)) {
+        perror("malloc");
+        jit_free(kernel);
+        return NULL;
+    }
+
+    emitter_t e = {kernel->code, 0};
+    for (uint32_t i = 0; i < count; i++) {
+        if (flags & JIT_TIMED) {
+            emit_mfence(&e);
+            emit_tsc(&e);
+            emit(&e, (const uint8_t[]){0x49, 0x89, 0xC0}, 3);     // mov r8, rax
+        }
+
+        emit_address(&e, lines[i], i, flags);
+        if (emit_op(&e, ops ? ops[i] : op) != 0) {
+            fprintf(stderr, "Error: jit_build: unsupported op %d at access %u\n", ops ? ops[i] : op, i);
+            jit_free(kernel);
+            return NULL;
+        }
+        if (flags & JIT_MFENCE) emit_mfence(&e);
+        if (flags & JIT_LFENCE) emit_lfence(&e);
+
+        if (flags & JIT_TIMED) {
+            emit_mfence(&e);
+            emit_tsc(&e);
+            emit(&e, (const uint8_t[]){0x4C, 0x29, 0xC0}, 3);     // sub rax, r8
+            emit(&e, (const uint8_t[]){0x48, 0x89, 0x86}, 3);     // mov [rsi + disp32], rax
+            emit32(&e, i * sizeof(uint64_t));
+        }
+    }
+    emit(&e, (const uint8_t[]){0xC3}, 1);                         // ret
+
+    if (mprotect(kernel->code, kernel->size, PROT_READ | PROT_EXEC) != 0) {
+        perror("mprotect");
+        jit_free(kernel);
+        return NULL;
+    }
+    kernel->fn = (jit_fn_t)kernel->code;
+    return kernel;
+}
+
+void jit_free(jit_kernel_t *kernel) {
+    if (!kernel) return;
+    munmap(kernel->code, kernel->size);
+    free(kernel->table);
+    free(kernel->cycles);
+    free(kernel);
+}
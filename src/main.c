@@ -7,171 +7,346 @@
 #include "benchmark.h"
 #include "msr_defs.h"
 #include "socket_memory.h"
+#include "evset.h"
+#include "actor.h"
+#include "timing.h"
+#include "stats.h"
+#include "phase.h"
+#include "session.h"
+#include "sweep.h"
+#include "server.h"
+#include "startup.h"
 #include "util.h"
 
-uint64_t new_counts[NUM_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS] = {0};
-
 int load_monitor_counters(char*** event_name_list, int* num_events_to_monitor);
 
+// Filled in by the startup stages
+typedef struct {
+  const char* benchmark_name;
+  const BenchmarkV2* benchmark;
+  int socket_map[MAX_SOCKETS];
+  int msr_fds[MAX_SOCKETS];
+  int num_sockets;
+  cha_event_t* events;
+  int num_events;
+  char** event_name_list;
+  int num_total_events;
+  int interactive;
+  int reuse_pool;
+} machine_t;
+
+// Only the requested benchmark's plugin is opened
+static int stage_plugin(void* arg) {
+  machine_t* m = arg;
+  m->benchmark = load_benchmark(m->benchmark_name);
+  return m->benchmark ? 0 : -1;
+}
+
+static int stage_msr(void* arg) {
+  machine_t* m = arg;
+  m->num_sockets = find_cpu_sockets(m->socket_map, MAX_SOCKETS);
+  if (m->num_sockets <= 0) {
+    fprintf(stderr, "Error: Could not determine CPU sockets.\n");
+    return -1;
+  }
+
+  if (open_msr_fds(m->socket_map, m->num_sockets, m->msr_fds) != 0) {
+    fprintf(stderr, "Error: Failed to open MSR file descriptors.\n");
+    return -1;
+  }
+  disable_prefetch(m->msr_fds, m->num_sockets);
+  return 0;
+}
+
+static int stage_catalog(void* arg) {
+  machine_t* m = arg;
+  // Parse CHA events from JSON file.
+  if (parse_cha_events(JSON_FILE_PATH, &m->events, &m->num_events) != 0) {
+    fprintf(stderr, "Error: Failed to parse CHA events.\n");
+    return -1;
+  }
+
+  // Load monitoring counters from "monitor" file; interactive selection
+  // waits for the other stages
+  if (!m->interactive && load_monitor_counters(&m->event_name_list, &m->num_total_events) != 0) {
+    fprintf(stderr, "Error: Failed to load monitoring counters.\n");
+    return -1;
+  }
+  return 0;
+}
+
+static int stage_cores(void* arg) {
+  find_primary_secondary_cores_per_socket();
+  return 0;
+}
+
+// Buffers of all nodes, first-touched by threads pinned to each node
+static int stage_memory(void* arg) {
+  allocate_memory_per_socket();
+  return 0;
+}
+
+static int stage_timing(void* arg) {
+  timing_init();
+  return 0;
+}
+
+static int stage_cha_map(void* arg) {
+  machine_t* m = arg;
+  if (m->reuse_pool && addr_pool_load(&address_pool, POOL_FILE) == 0 &&
+      validate_address_pool(&address_pool, m->msr_fds, m->num_sockets, m->events, m->num_events) == 0) {
+    printf("Reusing CHA mapping from %s\n", POOL_FILE);
+  } else {
+    if (m->reuse_pool) {
+      printf("Stored CHA mapping unusable, regenerating\n");
+    }
+    generate_cha_mapped_offsets(m->msr_fds, m->num_sockets, m->events, m->num_events);
+  }
+  return 0;
+}
+
 int main(int argc, char* argv[]) {
   // print MAX_SOCKETS
   printf("MAX_SOCKETS: %d\n", MAX_SOCKETS);
-  // Load all benchmarks dynamically
-  load_benchmarks();
+  startup_t startup;
+  startup_begin(&startup);
+  machine_t machine = {0};
 
   if (argc < 2) {
-    printf("Usage: %s <benchmark_name>\n", argv[0]);
+    printf("Usage: %s <benchmark_name> [options] | --sweep-file <file> [options] | --serve [options]\n",
+           argv[0]);
+    load_benchmarks();
     list_available_benchmarks();
     return EXIT_FAILURE;
   }
 
-  // Get the selected benchmark
-  Benchmark* benchmark = get_benchmark_by_name(argv[1]);
-  if (!benchmark) {
-    printf("Error: Benchmark '%s' not found!\n", argv[1]);
-    list_available_benchmarks();
-    return EXIT_FAILURE;
+  // Get the selected benchmark; sweep files and server requests name their own
+  if (strncmp(argv[1], "--", 2) != 0) {
+    machine.benchmark_name = argv[1];
+    if (startup_serial(&startup, "plugin", stage_plugin, &machine) != 0) {
+      printf("Error: Benchmark '%s' not found!\n", argv[1]);
+      list_available_benchmarks();
+      return EXIT_FAILURE;
+    }
   }
+  const BenchmarkV2* benchmark = machine.benchmark;
 
   int interactive = 0;
+  int reuse_pool = 0;
+  int verify_llc = 0;
+  int evset_specs[EVSET_MAX_PRESETS][3];
+  int near_socket = -1, near_cha = -1;
+  int num_evset_specs = 0;
+  bench_ctx_t ctx;
+  bench_ctx_init(&ctx, benchmark, &address_pool, 0);
+  char sweep_key[sizeof(ctx.params[0].key)] = "";
+  long sweep_first = 0, sweep_last = 0, sweep_step = 1;
+  int runs = NUM_RUNS;
+  int warmup_runs = 0;
+  double adaptive_width = 0;  // Target relative CI width, 0 for fixed runs
+  int max_runs = MAX_RUNS;
+  baseline_mode_t baseline = BASELINE_NONE;
+  int baseline_runs = NUM_RUNS;
+  const char* sweep_file = NULL;
+  int serve = 0;
+  const char* socket_path = SERVER_SOCKET;
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "--interactive") == 0) {
       interactive = 1;
-      break;
+    } else if (strcmp(argv[i], "--reuse-pool") == 0) {
+      reuse_pool = 1;
+    } else if (strcmp(argv[i], "--lines-per-cha") == 0 && i + 1 < argc) {
+      pool_lines_per_cha = atoi(argv[++i]);
+      if (pool_lines_per_cha <= 0) {
+        fprintf(stderr, "Error: --lines-per-cha needs a positive count\n");
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--verify-llc") == 0) {
+      verify_llc = 1;
+    } else if (strcmp(argv[i], "--near-cha") == 0 && i + 1 < argc) {
+      // Primary and secondary of that socket: the cores nearest the CHA
+      if (sscanf(argv[++i], "%d:%d", &near_socket, &near_cha) != 2 || near_socket < 0 ||
+          near_socket >= MAX_SOCKETS || near_cha < 0 || near_cha >= NUM_CHA) {
+        fprintf(stderr, "Error: --near-cha expects socket:cha\n");
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--evset") == 0 && i + 1 < argc) {
+      int* spec = evset_specs[num_evset_specs];
+      if (num_evset_specs >= EVSET_MAX_PRESETS ||
+          sscanf(argv[++i], "%d:%d:%d", &spec[0], &spec[1], &spec[2]) != 3) {
+        fprintf(stderr, "Error: --evset expects socket:cha:set (at most %d)\n", EVSET_MAX_PRESETS);
+        return EXIT_FAILURE;
+      }
+      num_evset_specs++;
+    } else if (strcmp(argv[i], "--param") == 0 && i + 1 < argc) {
+      if (bench_param_parse(&ctx, argv[++i]) != 0) {
+        fprintf(stderr, "Error: --param expects key=value\n");
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+      // key=first:last[:step], one full monitoring pass per value
+      if (sscanf(argv[++i], "%31[^=]=%ld:%ld:%ld", sweep_key, &sweep_first, &sweep_last, &sweep_step) < 3 ||
+          sweep_step <= 0 || sweep_last < sweep_first) {
+        fprintf(stderr, "Error: --sweep expects key=first:last[:step]\n");
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--sweep-file") == 0 && i + 1 < argc) {
+      // Every point of the file in this process, resuming from its checkpoint
+      sweep_file = argv[++i];
+    } else if (strcmp(argv[i], "--serve") == 0) {
+      // Stay resident and take run requests on a Unix socket
+      serve = 1;
+    } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      socket_path = argv[++i];
+    } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+      runs = atoi(argv[++i]);
+      if (runs < 1 || runs > MAX_RUNS) {
+        fprintf(stderr, "Error: --runs must be in [1, %d]\n", MAX_RUNS);
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+      warmup_runs = atoi(argv[++i]);
+      if (warmup_runs < 0 || warmup_runs > MAX_RUNS) {
+        fprintf(stderr, "Error: --warmup must be in [0, %d]\n", MAX_RUNS);
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--adaptive") == 0 && i + 1 < argc) {
+      // Repeat each event group until every per-CHA 95% CI is this wide
+      // relative to its mean (e.g. 0.05), or --max-runs
+      adaptive_width = atof(argv[++i]);
+      if (adaptive_width <= 0) {
+        fprintf(stderr, "Error: --adaptive expects a positive relative width\n");
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      // noop: the same window with an empty ROI; init: also run init/cleanup
+      i++;
+      baseline = strcmp(argv[i], "noop") == 0 ? BASELINE_NOOP
+               : strcmp(argv[i], "init") == 0 ? BASELINE_INIT : BASELINE_NONE;
+      if (baseline == BASELINE_NONE) {
+        fprintf(stderr, "Error: --baseline expects noop or init\n");
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--baseline-runs") == 0 && i + 1 < argc) {
+      baseline_runs = atoi(argv[++i]);
+      if (baseline_runs < 2 || baseline_runs > MAX_RUNS) {
+        fprintf(stderr, "Error: --baseline-runs must be in [2, %d]\n", MAX_RUNS);
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--max-runs") == 0 && i + 1 < argc) {
+      max_runs = atoi(argv[++i]);
+      if (max_runs < ADAPTIVE_MIN_RUNS || max_runs > MAX_RUNS) {
+        fprintf(stderr, "Error: --max-runs must be in [%d, %d]\n", ADAPTIVE_MIN_RUNS, MAX_RUNS);
+        return EXIT_FAILURE;
+      }
     }
   }
-
-  int socket_map[MAX_SOCKETS] = {0};
-  int msr_fds[MAX_SOCKETS];
-  int num_sockets = find_cpu_sockets(socket_map, MAX_SOCKETS);
-  if (num_sockets <= 0) {
-    fprintf(stderr, "Error: Could not determine CPU sockets.\n");
+  if (!benchmark && !sweep_file && !serve) {
+    fprintf(stderr, "Error: expected a benchmark name, --sweep-file or --serve\n");
     return EXIT_FAILURE;
   }
 
-  if (open_msr_fds(socket_map, num_sockets, msr_fds) != 0) {
-    fprintf(stderr, "Error: Failed to open MSR file descriptors.\n");
+  // Catalog, MSRs, cores and node memory do not depend on each other
+  machine.interactive = interactive;
+  machine.reuse_pool = reuse_pool;
+  startup_stage_t independent[] = {
+      {"catalog", stage_catalog, &machine},
+      {"msr", stage_msr, &machine},
+      {"cores", stage_cores, &machine},
+      {"memory", stage_memory, &machine},
+  };
+  if (startup_parallel(&startup, independent, sizeof(independent) / sizeof(independent[0])) != 0) {
+    startup_report(&startup);
     return EXIT_FAILURE;
   }
+  int* msr_fds = machine.msr_fds;
+  int num_sockets = machine.num_sockets;
+  cha_event_t* events = machine.events;
+  int num_events = machine.num_events;
 
-  // Parse CHA events from JSON file.
-  cha_event_t* events = NULL;
-  int num_events = 0;
-  if (parse_cha_events(JSON_FILE_PATH, &events, &num_events) != 0) {
-    fprintf(stderr, "Error: Failed to parse CHA events.\n");
-    return EXIT_FAILURE;
+  // Determine which events to program based on interactive flag.
+  if (interactive) {
+    select_cha_events(events, num_events, &machine.event_name_list, &machine.num_total_events);
   }
+  char** event_name_list = machine.event_name_list;
+  int num_total_events = machine.num_total_events;
 
-  // Determine which events to program based on interactive flag.
-  char** event_name_list = NULL;
-  int num_total_events = 0;
+  set_process_affinity(orchestrator_cores[0]);
+  startup_serial(&startup, "tsc calibration", stage_timing, NULL);
+  startup_serial(&startup, "cha map", stage_cha_map, &machine);
+  startup_report(&startup);
 
-  if (!interactive) {
-    // Load monitoring counters from "monitor" file
-    if (load_monitor_counters(&event_name_list, &num_total_events) != 0) {
-      fprintf(stderr, "Error: Failed to load monitoring counters.\n");
-      return EXIT_FAILURE;
-    }
-  } else {
-    select_cha_events(events, num_events, &event_name_list, &num_total_events);
+  if (near_socket >= 0 && select_cores_near_cha(&address_pool, near_socket, near_cha) == 0) {
+    print_core_roles();
   }
 
-  // Process events in batches of 4
-  int num_batches = (num_total_events + NUM_CTR_PER_CHA - 1) / NUM_CTR_PER_CHA;
-  int event_index = 0;  // Tracks the index for storing results
-
-  disable_prefetch(msr_fds, num_sockets);
+  // Eviction sets probe the CHA counters, so they are built before monitoring
+  for (int i = 0; i < num_evset_specs; i++) {
+    int* spec = evset_specs[i];
+    if (evset_build(&evsets[num_evsets], &address_pool, spec[0], spec[1], spec[2],
+                    msr_fds, num_sockets, events, num_events) > 0) {
+      printf("Eviction set: socket %d, CHA %d, set %d: %d lines\n", spec[0], spec[1],
+             spec[2], evsets[num_evsets].count);
+      num_evsets++;
+    }
+  }
 
-  // Memory allocation and initialization for monitoring
-  find_primary_secondary_cores_per_socket();
-  allocate_memory_per_socket();
-  set_process_affinity(orchestrator_cores[0]);
-  generate_cha_mapped_offsets(msr_fds, num_sockets, events, num_events);
+  // Check that evict_to_llc() leaves the first line of every CHA in its slice
+  if (verify_llc) {
+    int verified = 0, tested = 0;
+    for (int socket_id = 0; socket_id < num_sockets; socket_id++) {
+      for (int cha = 0; cha < NUM_CHA; cha++) {
+        private_evset_t pe;
+        if (pool_count(&address_pool, socket_id, cha) == 0 ||
+            private_evset_build(&pe, pool_addr(&address_pool, socket_id, cha, 0)) < 0) {
+          continue;
+        }
+        int hit = verify_llc_hit(&pe, socket_id, cha, msr_fds, num_sockets, events, num_events);
+        tested++;
+        if (hit > 0) {
+          verified++;
+        } else if (hit == 0) {
+          printf("LLC residency not confirmed: socket %d, CHA %d\n", socket_id, cha);
+        }
+      }
+    }
+    printf("LLC residency after private eviction: %d/%d CHAs confirmed\n", verified, tested);
+  }
 
-  DEBUG_PRINT("Monitoring %d events in %d batches", num_total_events, num_batches);
+  DEBUG_PRINT("Monitoring %d events in %d batches", num_total_events,
+              (num_total_events + NUM_CTR_PER_CHA - 1) / NUM_CTR_PER_CHA);
 
   // Set the global values before running the benchmark
-  set_global_values((void*)address_list, primary_cores, secondary_cores,
+  set_global_values((void*)&address_pool, primary_cores, secondary_cores,
                     orchestrator_cores);
+  ctx.num_sockets = num_sockets;
+  session_t session = {msr_fds, num_sockets, events, num_events, runs, warmup_runs,
+                       adaptive_width, max_runs, baseline, baseline_runs};
 
-  for (int batch = 0; batch < num_batches; batch++) {
-    // ------------------------------------------------------------------ 
-    // Since we can only monitor 4 events per CHA at a time, we need to
-    // program the counters in batches of 4. This loop will iterate over
-    // all events and program them in groups of 4.
-    int start_idx = batch * NUM_CTR_PER_CHA;
-    int num_events_to_program = (start_idx + NUM_CTR_PER_CHA > num_total_events)
-                                    ? num_total_events - start_idx
-                                    : NUM_CTR_PER_CHA;
-
-    char* event_group[NUM_CTR_PER_CHA];
-    for (int i = 0; i < num_events_to_program; i++) {
-      event_group[i] = event_name_list[start_idx + i];
-    }
-
-    printf("Monitoring session %d/%d: ", batch + 1, num_batches);
-    for (int i = 0; i < num_events_to_program; i++) {
-      printf("%s ", event_group[i]);
+  int status = EXIT_SUCCESS;
+  if (sweep_file && sweep_run(sweep_file, &session, &ctx, event_name_list, num_total_events) != 0) {
+    status = EXIT_FAILURE;
+  }
+  if (serve && server_run(socket_path, &session, &ctx, event_name_list, num_total_events) != 0) {
+    status = EXIT_FAILURE;
+  }
+  for (long sweep_value = sweep_first; benchmark && sweep_value <= sweep_last; sweep_value += sweep_step) {
+    char output_name[256];
+    snprintf(output_name, sizeof(output_name), "%s", benchmark->name);
+    if (sweep_key[0]) {
+      char value[32];
+      snprintf(value, sizeof(value), "%ld", sweep_value);
+      bench_param_set(&ctx, sweep_key, value);
+      snprintf(output_name, sizeof(output_name), "%s_%s%ld", benchmark->name, sweep_key, sweep_value);
+      printf("Sweep: %s=%ld\n", sweep_key, sweep_value);
     }
-    printf("\n");
-
-    // ------------------------------------------------------------------
-    // Set up a PMU monitoring session following documentation:
-    //
-    // Step (a): Freeze all uncore counters globally.
-    // Step (d): Reset counters in each box (done in configure_cha_counters).
-    // Step (b) & (c): Program event control registers and enable each monitor.
-    // Step (f): Unfreeze counters to begin counting.
-    // ------------------------------------------------------------------
-
-    // Step (a): Freeze counters globally before configuration.
-    freeze_counters_global(msr_fds, num_sockets);
-
-    // Monitoring session: perform measurements over NUM_RUNS iterations.
-    for (int run_idx = 0; run_idx < NUM_RUNS; run_idx++) {
-      // Steps (d), (b), (c): Reset counters and program event control
-      // registers. This call resets the counters in each CHA (by writing 0x3 to
-      // unit control registers) and then programs the control registers with
-      // enable (.en), event selection (.ev_sel) and umask bits for each
-      // requested event. Note: Currently U_MSR_PMON_UNIT_CTL_rst_both is
-      // working. if not, use delta calculation
-      configure_cha_counters(msr_fds, num_sockets, events, num_events,
-                             event_group, num_events_to_program);
-
-      // Bench: Preconfigure the benchmark here
-      benchmark->init((void*)address_list, primary_cores, secondary_cores,
-                      orchestrator_cores);
-
-      // Step (f): Unfreeze global counters to start counting.
-      unfreeze_counters_global(msr_fds, num_sockets);
-
-      // Bench: Run the benchmark here
-      benchmark->roi((void*)address_list, primary_cores, secondary_cores,
-                     orchestrator_cores);
-
-      // Freeze counters to stop counting at the end of the monitoring interval.
-      freeze_counters_global(msr_fds, num_sockets);
-
-      // Run cleanup (if available)
-      if (benchmark->cleanup) {
-        benchmark->cleanup((void*)address_list, primary_cores, secondary_cores,
-                           orchestrator_cores);
-      }
-
-      // Read new counter values after measurement interval.
-      read_cha_counters(msr_fds, num_sockets, events, num_events, event_group,
-                        num_events_to_program, run_idx, new_counts,
-                        event_index);
+    if (run_session(&session, benchmark, &ctx, event_name_list, num_total_events, output_name) != 0) {
+      status = EXIT_FAILURE;
     }
-
-    event_index += num_events_to_program;  // Move index forward
   }
 
-  // Write event counts to output file.
-  write_event_counts(new_counts, num_total_events, num_sockets, event_name_list,
-                     benchmark->name);
-
   // Cleanup resources.
+  actor_stop_all();
   free_cha_events(events, num_events);
   close_msr_fds(msr_fds, num_sockets);
 
@@ -183,7 +358,7 @@ int main(int argc, char* argv[]) {
     free(event_name_list);
   }
 
-  return EXIT_SUCCESS;
+  return status;
 }
 
 // Function to load monitoring counters from a file
@@ -252,7 +252,7 @@ void read_cha_counters(
     char* event_name_list[],
     int num_events_to_program,
     int run_idx,
-    uint64_t counts[NUM_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS],
+    uint64_t counts[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS],
     int event_index) {
   if (msr_fds == NULL || event_name_list == NULL) {
     fprintf(stderr, "Error: NULL pointer passed to read_cha_counters\n");
@@ -369,7 +369,8 @@ int create_directory_recursively(const char* path) {
 }
 
 void write_event_counts(
-    uint64_t counts[NUM_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS],
+    uint64_t counts[MAX_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS],
+    const int runs[MAX_MONITOR_EVENTS],
     int num_events_to_program,
     int num_sockets,
     char** event_name_list,
@@ -471,7 +472,7 @@ void write_event_counts(
       double socket_total = 0.0;
       double socket_max = 0.0;
 
-      for (int run = 0; run < NUM_RUNS; run++) {
+      for (int run = 0; run < runs[event]; run++) {
         for (int cha = 0; cha < NUM_CHA; cha++) {
           double event_count = counts[run][socket][cha][event];
           socket_total += event_count;
@@ -482,12 +483,12 @@ void write_event_counts(
         }
       }
 
-      per_socket_avg[socket] = socket_total / (NUM_RUNS * NUM_CHA);
+      per_socket_avg[socket] = socket_total / (runs[event] * NUM_CHA);
       per_socket_max[socket] = socket_max;
     }
 
     double avg_event_count =
-        total_event_count / (NUM_RUNS * num_sockets * NUM_CHA);
+        total_event_count / (runs[event] * num_sockets * NUM_CHA);
 
     // Print event name and overall avg
     LOG("%s%-*s%s %s%10.2f", BOLD_GREEN, max_event_name_len,
@@ -522,10 +523,10 @@ void write_event_counts(
       LOG("%-5d", cha);
       for (int socket = 0; socket < num_sockets; socket++) {
         double cha_event_count = 0.0;
-        for (int run = 0; run < NUM_RUNS; run++) {
+        for (int run = 0; run < runs[event]; run++) {
           cha_event_count += counts[run][socket][cha][event];
         }
-        double avg_cha_event_count = cha_event_count / NUM_RUNS;
+        double avg_cha_event_count = cha_event_count / runs[event];
         LOG(" %s%10.2f%s", BOLD_WHITE, avg_cha_event_count, RESET);
       }
       LOG("\n");
@@ -539,27 +540,27 @@ void write_event_counts(
   for (int event = 0; event < num_events_to_program; event++) {
     LOG("\n%sEvent: %s%s\n", BOLD_GREEN, event_name_list[event], RESET);
     LOG("%s%-5s %-5s", BOLD_CYAN, "Soc", "CHA");
-    for (int run = 0; run < NUM_RUNS; run++) {
+    for (int run = 0; run < runs[event]; run++) {
       LOG(" %8d", run);
     }
     LOG(" %10s %10s%s\n", "Avg", "Std Dev", RESET);
 
     for (int socket = 0; socket < num_sockets; socket++) {
       for (int cha = 0; cha < NUM_CHA; cha++) {
-        double run_counts[NUM_RUNS];
+        double run_counts[MAX_RUNS];
         double sum = 0.0, sum_sq = 0.0;
 
         LOG("%-5d %-5d", socket, cha);
 
-        for (int run = 0; run < NUM_RUNS; run++) {
+        for (int run = 0; run < runs[event]; run++) {
           run_counts[run] = counts[run][socket][cha][event];
           sum += run_counts[run];
           sum_sq += run_counts[run] * run_counts[run];
           LOG(" %8.0f", run_counts[run]);
         }
 
-        double avg = sum / NUM_RUNS;
-        double variance = (sum_sq / NUM_RUNS) - (avg * avg);
+        double avg = sum / runs[event];
+        double variance = (sum_sq / runs[event]) - (avg * avg);
         double stdev = sqrt(variance);
 
         LOG(" %s%10.2f %10.2f%s\n", BOLD_WHITE, avg, stdev, RESET);
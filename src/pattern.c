@@ -0,0 +1,333 @@
+#include <string.h>
+#include <jansson.h>
+#include "pattern.h"
+#include "phase.h"
+
+static pattern_t pattern;
+
+static const char *stage_names[] = {"init", "roi", "cleanup"};
+static const char *op_names[] = {"read", "write", "flush", "atomic"};
+static const char *order_names[] = {"cha", "address"};
+static const char *role_names[] = {"primary", "secondary", "orchestrator", "caller"};
+
+static int lookup(const char *value, const char **names, int count) {
+    for (int i = 0; value && i < count; i++) {
+        if (strcmp(value, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static int parse_actor(json_t *obj, pattern_actor_t *actor) {
+    if (!obj || (json_is_string(obj) && strcmp(json_string_value(obj), "caller") == 0)) {
+        actor->role = ROLE_CALLER;
+        return 0;
+    }
+    if (!json_is_object(obj)) return -1;
+
+    actor->role = lookup(json_string_value(json_object_get(obj, "role")), role_names, ROLE_CALLER);
+    actor->socket = json_integer_value(json_object_get(obj, "socket"));
+    actor->migrate = json_is_true(json_object_get(obj, "migrate"));
+    return actor->role < 0 ? -1 : 0;
+}
+
+static int parse_lines(json_t *obj, pattern_phase_t *phase) {
+    if (!json_is_object(obj)) return -1;
+
+    phase->socket = json_integer_value(json_object_get(obj, "socket"));
+    phase->first = json_integer_value(json_object_get(obj, "first"));
+    phase->count = json_integer_value(json_object_get(obj, "count"));
+
+    json_t *chas = json_object_get(obj, "chas");
+    phase->num_chas = 0;
+    if (!chas || (json_is_string(chas) && strcmp(json_string_value(chas), "all") == 0)) {
+        for (int cha = 0; cha < NUM_CHA; cha++) phase->chas[phase->num_chas++] = cha;
+    } else if (json_is_integer(chas)) {
+        phase->chas[phase->num_chas++] = json_integer_value(chas);
+    } else if (json_is_array(chas)) {
+        for (size_t i = 0; i < json_array_size(chas) && phase->num_chas < NUM_CHA; i++) {
+            phase->chas[phase->num_chas++] = json_integer_value(json_array_get(chas, i));
+        }
+    } else {
+        return -1;
+    }
+
+    for (int i = 0; i < phase->num_chas; i++) {
+        if (phase->chas[i] < 0 || phase->chas[i] >= NUM_CHA) return -1;
+    }
+    return 0;
+}
+
+static int parse_phase(json_t *obj, pattern_phase_t *phase) {
+    memset(phase, 0, sizeof(*phase));
+
+    int stage = lookup(json_string_value(json_object_get(obj, "stage")), stage_names, 3);
+    int op = lookup(json_string_value(json_object_get(obj, "op")), op_names, 4);
+    json_t *order = json_object_get(obj, "order");
+    json_t *fence = json_object_get(obj, "fence");
+    if (stage < 0 || op < 0) return -1;
+
+    phase->stage = stage;
+    phase->op = op;  // op_names follows actor_op_t
+    phase->order = order ? lookup(json_string_value(order), order_names, 2) : ORDER_CHA;
+    phase->fence = fence ? json_is_true(fence) : 1;
+    phase->timed = json_is_true(json_object_get(obj, "timed"));
+    if ((int)phase->order < 0) return -1;
+
+    json_t *actor = json_object_get(obj, "actor");
+    if (json_is_array(actor)) {
+        for (size_t i = 0; i < json_array_size(actor) && phase->num_actors < MAX_PATTERN_ACTORS; i++) {
+            pattern_actor_t *a = &phase->actors[phase->num_actors++];
+            if (parse_actor(json_array_get(actor, i), a) != 0) return -1;
+            if (a->role == ROLE_CALLER || a->migrate) return -1;  // Turns are taken by pinned actors only
+        }
+    } else {
+        if (parse_actor(actor, &phase->actors[0]) != 0) return -1;
+        phase->num_actors = 1;
+    }
+
+    // Timed phases run on the calling thread
+    if (phase->timed && (phase->num_actors > 1 ||
+                         !(phase->actors[0].role == ROLE_CALLER || phase->actors[0].migrate))) {
+        return -1;
+    }
+
+    return parse_lines(json_object_get(obj, "lines"), phase);
+}
+
+// Name of the benchmark a spec file defines
+int pattern_spec_name(const char *path, char *name, size_t len) {
+    json_error_t error;
+    json_t *root = json_load_file(path, 0, &error);
+    if (!root) return -1;
+
+    const char *value = json_string_value(json_object_get(root, "name"));
+    if (value) snprintf(name, len, "%s", value);
+    json_decref(root);
+    return value ? 0 : -1;
+}
+
+// Drop the compiled lines and kernels of the active pattern
+static void pattern_release() {
+    for (int p = 0; p < pattern.num_phases; p++) {
+        pattern_phase_t *phase = &pattern.phases[p];
+        jit_free(phase->kernel);
+        free(phase->lines);
+        phase->kernel = NULL;
+        phase->lines = NULL;
+    }
+    pattern.compiled = 0;
+}
+
+// Parse a spec into the active pattern. Lines are resolved on the first init,
+// once the address pool is known.
+int pattern_load(const char *path) {
+    json_error_t error;
+    json_t *root = json_load_file(path, 0, &error);
+    if (!root) {
+        fprintf(stderr, "Error: %s:%d: %s\n", path, error.line, error.text);
+        return -1;
+    }
+
+    pattern_release();
+    memset(&pattern, 0, sizeof(pattern));
+    snprintf(pattern.name, sizeof(pattern.name), "%s", json_string_value(json_object_get(root, "name")));
+
+    json_t *phases = json_object_get(root, "phases");
+    if (!json_is_array(phases) || json_array_size(phases) > MAX_PATTERN_PHASES) {
+        fprintf(stderr, "Error: %s needs a \"phases\" array of at most %d entries\n", path, MAX_PATTERN_PHASES);
+        json_decref(root);
+        return -1;
+    }
+
+    for (size_t i = 0; i < json_array_size(phases); i++) {
+        if (parse_phase(json_array_get(phases, i), &pattern.phases[pattern.num_phases]) != 0) {
+            fprintf(stderr, "Error: %s: invalid phase %zu\n", path, i);
+            json_decref(root);
+            return -1;
+        }
+        pattern.num_phases++;
+    }
+
+    json_decref(root);
+    return 0;
+}
+
+// Resolve a phase's (socket, CHAs, range, order) into a flat line array
+static int compile_phase(pattern_phase_t *phase, addr_pool_t *pool) {
+    int socket_id = pool_socket(pool, phase->socket);
+    uint32_t counts[NUM_CHA];
+    uint32_t total = 0, longest = 0;
+
+    for (int i = 0; i < phase->num_chas; i++) {
+        uint32_t available = pool_count(pool, socket_id, phase->chas[i]);
+        available = available > phase->first ? available - phase->first : 0;
+        counts[i] = phase->count && phase->count < available ? phase->count : available;
+        total += counts[i];
+        if (counts[i] > longest) longest = counts[i];
+    }
+
+    phase->lines = malloc((total ? total : 1) * sizeof(void *));
+    if (!phase->lines) {
+        perror("malloc");
+        return -1;
+    }
+
+    uint32_t n = 0;
+    if (phase->order == ORDER_CHA) {
+        for (int i = 0; i < phase->num_chas; i++) {
+            const pool_list_t *list = pool_list(pool, socket_id, phase->chas[i]);
+            for (uint32_t j = 0; j < counts[i]; j++) {
+                phase->lines[n++] = pool_line(list, phase->first + j);
+            }
+        }
+    } else {
+        for (uint32_t j = 0; j < longest; j++) {
+            for (int i = 0; i < phase->num_chas; i++) {
+                if (j >= counts[i]) continue;
+                phase->lines[n++] = pool_line(pool_list(pool, socket_id, phase->chas[i]), phase->first + j);
+            }
+        }
+    }
+    phase->num_lines = n;
+
+    pattern_actor_t *actor = &phase->actors[0];
+    if (phase->stage == PATTERN_ROI && n > 0 && (actor->role == ROLE_CALLER || actor->migrate)) {
+        unsigned flags = (phase->fence ? JIT_MFENCE : 0) | (phase->timed ? JIT_TIMED : 0);
+        phase->kernel = jit_build(phase->lines, NULL, phase->op, n, flags);  // Falls back to the loops
+    }
+    return 0;
+}
+
+#define PATTERN_LOOP(access, fenced)               \
+    for (uint32_t i = 0; i < n; i++) {             \
+        access(lines[i]);                          \
+        if (fenced) mfence();                      \
+    }
+
+#define PATTERN_TIMED_LOOP(access)                 \
+    for (uint32_t i = 0; i < n; i++) {             \
+        uint64_t start = rdtsc();                  \
+        access(lines[i]);                          \
+        uint64_t end = rdtsc();                    \
+        cycles += end - start;                     \
+    }
+
+#define PATTERN_DISPATCH(access)                   \
+    if (phase->timed) {                            \
+        PATTERN_TIMED_LOOP(access)                 \
+    } else if (phase->fence) {                     \
+        PATTERN_LOOP(access, 1)                    \
+    } else {                                       \
+        PATTERN_LOOP(access, 0)                    \
+    }
+
+// Calling-thread execution: the op and fencing are resolved once per phase,
+// so the loop body is the access itself
+static void run_local(pattern_phase_t *phase) {
+    void **lines = phase->lines;
+    uint32_t n = phase->num_lines;
+    uint64_t cycles = 0;
+
+    if (phase->kernel) {
+        jit_run(phase->kernel);
+        for (uint32_t i = 0; phase->timed && i < n; i++) cycles += phase->kernel->cycles[i];
+    } else switch (phase->op) {
+        case ACTOR_READ:   PATTERN_DISPATCH(maccess); break;
+        case ACTOR_WRITE:  PATTERN_DISPATCH(mmodify); break;
+        case ACTOR_FLUSH:  PATTERN_DISPATCH(flush); break;
+        case ACTOR_ATOMIC: PATTERN_DISPATCH(matomic); break;
+        default: break;
+    }
+    mfence();
+
+    if (phase->timed) {
+        phase->cycles += cycles;
+        phase->samples += n;
+    }
+}
+
+static int actor_core(const pattern_actor_t *actor, addr_pool_t *pool,
+                      int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+    int socket_id = pool_socket(pool, actor->socket);
+    switch (actor->role) {
+        case ROLE_PRIMARY: return primary_cores[socket_id];
+        case ROLE_SECONDARY: return secondary_cores[socket_id];
+        case ROLE_ORCHESTRATOR: return orchestrator_cores[socket_id];
+        default: return -1;
+    }
+}
+
+static void run_stage(pattern_stage_t stage, addr_pool_t *pool,
+                      int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+    int stage_phase = 0;
+    for (int p = 0; p < pattern.num_phases; p++) {
+        pattern_phase_t *phase = &pattern.phases[p];
+        if (phase->stage != stage || phase->num_lines == 0) continue;
+
+        // Each ROI phase after the first gets its own counter snapshot
+        if (stage == PATTERN_ROI && stage_phase > 0) bench_mark_phase(stage_phase);
+        stage_phase++;
+
+        pattern_actor_t *first = &phase->actors[0];
+        if (first->role == ROLE_CALLER || first->migrate) {
+            if (first->migrate) {
+                set_process_affinity(actor_core(first, pool, primary_cores, secondary_cores, orchestrator_cores));
+            }
+            run_local(phase);
+            continue;
+        }
+
+        actor_t *actors[MAX_PATTERN_ACTORS];
+        for (int a = 0; a < phase->num_actors; a++) {
+            actors[a] = actor_get(actor_core(&phase->actors[a], pool, primary_cores, secondary_cores,
+                                             orchestrator_cores));
+        }
+
+        if (phase->num_actors == 1) {
+            actor_submit_lines(actors[0], phase->op, phase->lines, phase->num_lines);
+        } else {
+            // Every actor accesses each line in turn before the next line
+            for (uint32_t i = 0; i < phase->num_lines; i++) {
+                for (int a = 0; a < phase->num_actors; a++) {
+                    actor_after(actors[a], actors[(a + phase->num_actors - 1) % phase->num_actors]);
+                    actor_submit_lines(actors[a], phase->op, phase->lines + i, 1);
+                }
+            }
+        }
+        actor_sync(actors[phase->num_actors - 1]);
+        actor_sync_all();
+    }
+}
+
+void pattern_init(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+    addr_pool_t* pool = addr_list;
+
+    if (!pattern.compiled) {
+        for (int p = 0; p < pattern.num_phases; p++) {
+            if (compile_phase(&pattern.phases[p], pool) != 0) {
+                pattern_release();
+                return;
+            }
+        }
+        pattern.compiled = 1;
+    }
+    run_stage(PATTERN_INIT, pool, primary_cores, secondary_cores, orchestrator_cores);
+}
+
+void pattern_roi(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+    run_stage(PATTERN_ROI, addr_list, primary_cores, secondary_cores, orchestrator_cores);
+}
+
+void pattern_cleanup(void* addr_list, int* primary_cores, int* secondary_cores, int* orchestrator_cores) {
+    run_stage(PATTERN_CLEANUP, addr_list, primary_cores, secondary_cores, orchestrator_cores);
+
+    for (int p = 0; p < pattern.num_phases; p++) {
+        pattern_phase_t *phase = &pattern.phases[p];
+        if (!phase->timed || phase->samples == 0) continue;
+        printf("%s: phase %d (%s %s): %lu accesses, %.1f cycles/access\n", pattern.name, p,
+               stage_names[phase->stage], op_names[phase->op], phase->samples,
+               (double)phase->cycles / phase->samples);
+        phase->cycles = 0;
+        phase->samples = 0;
+    }
+}
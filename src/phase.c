@@ -0,0 +1,89 @@
+#include <string.h>
+#include "phase.h"
+
+uint64_t phase_counts[MAX_PHASES][MAX_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS];
+int num_phases = 0;
+
+// Cumulative counts at each mark of the current run
+static uint64_t marks[MAX_PHASES][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS];
+static int marked[MAX_PHASES];
+
+static struct {
+    int *msr_fds;
+    int num_sockets;
+    cha_event_t *events;
+    int num_events;
+    char **event_group;
+    int num_events_to_program;
+    int event_index;
+    int run_idx;
+    int active;     // Inside a benchmark's ROI window
+} session;
+
+// Counters of the event group about to be measured
+void phase_session(int *msr_fds, int num_sockets, cha_event_t *events, int num_events,
+                   char **event_group, int num_events_to_program, int event_index) {
+    session.msr_fds = msr_fds;
+    session.num_sockets = num_sockets;
+    session.events = events;
+    session.num_events = num_events;
+    session.event_group = event_group;
+    session.num_events_to_program = num_events_to_program;
+    session.event_index = event_index;
+}
+
+void phase_begin_run(int run_idx) {
+    session.run_idx = run_idx;
+    session.active = 1;
+    memset(marked, 0, sizeof(marked));
+}
+
+// Freeze, snapshot every CHA counter, unfreeze. The snapshot is read while
+// frozen, so only the two global MSR writes land in the counts.
+void bench_mark_phase(int phase) {
+    if (!session.active || phase <= 0 || phase >= MAX_PHASES) return;
+
+    freeze_counters_global(session.msr_fds, session.num_sockets);
+    read_cha_counters(session.msr_fds, session.num_sockets, session.events, session.num_events,
+                      session.event_group, session.num_events_to_program, 0, &marks[phase],
+                      session.event_index);
+    marked[phase] = 1;
+    unfreeze_counters_global(session.msr_fds, session.num_sockets);
+}
+
+// Split the run's final counts at the marks. Phases that were not marked
+// this run count zero.
+void phase_end_run(uint64_t counts[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS]) {
+    session.active = 0;
+
+    int last = 0;
+    for (int p = 1; p < MAX_PHASES; p++) {
+        if (marked[p]) last = p;
+    }
+    if (last == 0 && num_phases == 0) return;  // Benchmark does not mark phases
+    if (last + 1 > num_phases) num_phases = last + 1;
+
+    int run = session.run_idx;
+    for (int s = 0; s < session.num_sockets; s++) {
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            for (int j = 0; j < session.num_events_to_program; j++) {
+                int e = session.event_index + j;
+                uint64_t start = 0;
+                for (int p = 0; p < MAX_PHASES; p++) {
+                    phase_counts[p][run][s][cha][e] = 0;
+                    if (p > 0 && !marked[p]) continue;
+                    int next = p + 1;
+                    while (next < MAX_PHASES && !marked[next]) next++;
+                    uint64_t end = next < MAX_PHASES ? marks[next][s][cha][e] : counts[run][s][cha][e];
+                    phase_counts[p][run][s][cha][e] = end - start;
+                    start = end;
+                }
+            }
+        }
+    }
+}
+
+void phase_reset() {
+    num_phases = 0;
+    memset(phase_counts, 0, sizeof(phase_counts));
+}
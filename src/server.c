@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <jansson.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "server.h"
+#include "phase.h"
+
+static json_t *error_reply(const char *message) {
+    return json_pack("{s:s, s:s}", "status", "error", "error", message);
+}
+
+// Files the session wrote, as run_session names them
+static json_t *result_paths(const session_t *s, const char *output_name) {
+    json_t *results = json_array();
+    char path[512];
+    snprintf(path, sizeof(path), "output/current/%s.log", output_name);
+    json_array_append_new(results, json_string(path));
+    for (int phase = 0; num_phases > 1 && phase < num_phases; phase++) {
+        snprintf(path, sizeof(path), "output/current/%s_phase%d.log", output_name, phase);
+        json_array_append_new(results, json_string(path));
+    }
+    if (s->baseline != BASELINE_NONE) {
+        snprintf(path, sizeof(path), "output/current/%s_baseline.log", output_name);
+        json_array_append_new(results, json_string(path));
+    }
+    return results;
+}
+
+static json_t *handle_run(json_t *request, const session_t *server_session, const bench_ctx_t *base,
+                          char **event_name_list, int num_total_events) {
+    const char *name = json_string_value(json_object_get(request, "benchmark"));
+    if (!name) return error_reply("missing 'benchmark'");
+    if (json_is_true(json_object_get(request, "reload")) && reload_benchmark(name) != 0) {
+        return error_reply("reload failed");
+    }
+    const BenchmarkV2 *benchmark = load_benchmark(name);
+    if (!benchmark) return error_reply("unknown benchmark");
+
+    session_t s = *server_session;
+    json_t *runs = json_object_get(request, "runs");
+    if (runs) {
+        s.runs = json_integer_value(runs);
+        if (!json_is_integer(runs) || s.runs < 1 || s.runs > MAX_RUNS) return error_reply("bad 'runs'");
+    }
+
+    bench_ctx_t ctx;
+    bench_ctx_init(&ctx, benchmark, base->pool, base->num_sockets);
+    for (int i = 0; i < base->num_params; i++) {
+        bench_param_set(&ctx, base->params[i].key, base->params[i].value);
+    }
+    const char *key;
+    json_t *value;
+    json_object_foreach(json_object_get(request, "params"), key, value) {
+        char *text = json_is_string(value) ? strdup(json_string_value(value)) : json_dumps(value, JSON_ENCODE_ANY);
+        int ret = text ? bench_param_set(&ctx, key, text) : -1;
+        free(text);
+        if (ret != 0) return error_reply("bad 'params'");
+    }
+
+    char *names[MAX_MONITOR_EVENTS];
+    char **event_names = event_name_list;
+    int num_events = num_total_events;
+    json_t *events = json_object_get(request, "events");
+    if (events) {
+        if (!json_is_array(events) || json_array_size(events) == 0 || json_array_size(events) > MAX_MONITOR_EVENTS) {
+            return error_reply("'events' must list 1 to MAX_MONITOR_EVENTS names");
+        }
+        size_t i;
+        json_array_foreach(events, i, value) {
+            if (!json_is_string(value)) return error_reply("'events' must list 1 to MAX_MONITOR_EVENTS names");
+            names[i] = (char *)json_string_value(value);
+        }
+        event_names = names;
+        num_events = json_array_size(events);
+        if (session_check_events(&s, event_names, num_events) != 0) return error_reply("unknown event");
+    }
+
+    char output_name[256] = "";
+    const char *requested = json_string_value(json_object_get(request, "name"));
+    snprintf(output_name, sizeof(output_name), "%s", requested ? requested : benchmark->name);
+    if (strchr(output_name, '/') || strstr(output_name, "..")) return error_reply("bad 'name'");
+
+    printf("Server: running %s as %s\n", benchmark->name, output_name);
+    if (run_session(&s, benchmark, &ctx, event_names, num_events, output_name) != 0) {
+        return error_reply("setup rejected the parameters");
+    }
+    return json_pack("{s:s, s:o}", "status", "ok", "results", result_paths(&s, output_name));
+}
+
+static json_t *handle_request(const char *line, int *shutdown, const session_t *s, const bench_ctx_t *base,
+                              char **event_name_list, int num_total_events) {
+    json_error_t error;
+    json_t *request = json_loads(line, 0, &error);
+    if (!json_is_object(request)) {
+        json_decref(request);
+        return error_reply("request is not a JSON object");
+    }
+
+    json_t *reply;
+    const char *cmd = json_string_value(json_object_get(request, "cmd"));
+    if (!cmd || strcmp(cmd, "run") == 0) {
+        reply = handle_run(request, s, base, event_name_list, num_total_events);
+    } else if (strcmp(cmd, "list") == 0) {
+        load_benchmarks();
+        json_t *names = json_array();
+        for (int i = 0; benchmark_at(i); i++) {
+            json_array_append_new(names, json_string(benchmark_at(i)->name));
+        }
+        reply = json_pack("{s:s, s:o}", "status", "ok", "benchmarks", names);
+    } else if (strcmp(cmd, "reload") == 0) {
+        const char *name = json_string_value(json_object_get(request, "benchmark"));
+        reply = name && reload_benchmark(name) == 0 ? json_pack("{s:s}", "status", "ok")
+                                                    : error_reply("reload failed");
+    } else if (strcmp(cmd, "shutdown") == 0) {
+        *shutdown = 1;
+        reply = json_pack("{s:s}", "status", "ok");
+    } else {
+        reply = error_reply("unknown cmd");
+    }
+    json_decref(request);
+    return reply;
+}
+
+static long monotonic_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+// Read one newline- or EOF-terminated request within SERVER_READ_TIMEOUT,
+// so a client that connects and stalls cannot hold the server. *timed_out
+// is set if the deadline passed first.
+static char *read_request(int fd, int *timed_out) {
+    char *buf = malloc(SERVER_MAX_REQUEST);
+    size_t len = 0;
+    long deadline = monotonic_ms() + SERVER_READ_TIMEOUT * 1000L;
+    *timed_out = 0;
+    while (buf && len < SERVER_MAX_REQUEST - 1) {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        long left = deadline - monotonic_ms();
+        if (left <= 0 || poll(&pfd, 1, left) <= 0) {
+            *timed_out = 1;
+            break;
+        }
+        ssize_t n = read(fd, buf + len, SERVER_MAX_REQUEST - 1 - len);
+        if (n <= 0) break;
+        len += n;
+        if (memchr(buf + len - n, '\n', n)) break;
+    }
+    if (buf) buf[len] = '\0';
+    return buf;
+}
+
+int server_run(const char *socket_path, const session_t *s, const bench_ctx_t *base,
+               char **event_name_list, int num_total_events) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: socket path %s too long\n", socket_path);
+        return -1;
+    }
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    unlink(socket_path);
+    // Requests run as whoever started the server: owner only
+    mode_t old_mask = umask(0077);
+    int bound = bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(old_mask);
+    if (bound != 0 || listen(listen_fd, 8) != 0) {
+        perror("bind/listen");
+        close(listen_fd);
+        return -1;
+    }
+    printf("Server: listening on %s\n", socket_path);
+    fflush(stdout);
+
+    int shutdown = 0;
+    while (!shutdown) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            perror("accept");
+            continue;
+        }
+
+        int timed_out;
+        char *line = read_request(fd, &timed_out);
+        json_t *reply = !line      ? error_reply("out of memory")
+                        : timed_out ? error_reply("request timed out")
+                                    : handle_request(line, &shutdown, s, base, event_name_list, num_total_events);
+        char *text = json_dumps(reply, JSON_COMPACT);
+        if (text) {
+            // The client may be gone; that must not take the server down
+            send(fd, text, strlen(text), MSG_NOSIGNAL);
+            send(fd, "\n", 1, MSG_NOSIGNAL);
+        }
+        free(text);
+        json_decref(reply);
+        free(line);
+        close(fd);
+        fflush(stdout);
+    }
+
+    close(listen_fd);
+    unlink(socket_path);
+    printf("Server: shut down\n");
+    return 0;
+}
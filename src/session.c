@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <string.h>
+#include "session.h"
+#include "phase.h"
+#include "stats.h"
+#include "timing.h"
+#include "topology.h"
+
+uint64_t new_counts[MAX_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS] = {0};
+int runs_per_event[MAX_MONITOR_EVENTS];
+static uint64_t baseline_counts[MAX_RUNS][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS] = {0};
+static int baseline_runs_per_event[MAX_MONITOR_EVENTS];
+
+static const char *baseline_names[] = {"none", "noop", "init"};
+
+// Stands in for benchmark->roi during baseline runs
+static void empty_roi(bench_ctx_t *ctx) {}
+static void (*volatile baseline_roi)(bench_ctx_t*) = empty_roi;
+
+// Which cores played which role, next to the counts they produced
+static void write_session_layout(const char *output_name) {
+    char path[512];
+    snprintf(path, sizeof(path), "output/current/%s_layout.log", output_name);
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        perror("Error opening layout log");
+        return;
+    }
+    write_core_layout(fp);
+    fclose(fp);
+}
+
+// Every name must resolve: configure_cha_counters would leave the counter of
+// an unknown one unprogrammed and the session would report zeros for it
+int session_check_events(const session_t *s, char **event_name_list, int num_total_events) {
+    int ret = 0;
+    for (int i = 0; i < num_total_events; i++) {
+        unsigned int event_code, umask;
+        if (get_event_code_and_umask(s->events, s->num_events, event_name_list[i], &event_code, &umask) != 0) {
+            fprintf(stderr, "Error: event %s is not in the catalog\n", event_name_list[i]);
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+int run_session(const session_t *s, const BenchmarkV2 *benchmark, bench_ctx_t *ctx,
+                char **event_name_list, int num_total_events, const char *output_name) {
+    if (session_check_events(s, event_name_list, num_total_events) != 0) return -1;
+    if (benchmark->setup && benchmark->setup(ctx) != 0) {
+        fprintf(stderr, "Warning: %s setup failed, skipping\n", output_name);
+        return -1;
+    }
+    memset(new_counts, 0, sizeof(new_counts));
+    phase_reset();
+
+    // Process events in batches of 4
+    int num_batches = (num_total_events + NUM_CTR_PER_CHA - 1) / NUM_CTR_PER_CHA;
+    int event_index = 0;  // Tracks the index for storing results
+
+    for (int batch = 0; batch < num_batches; batch++) {
+        // ------------------------------------------------------------------ 
+        // Since we can only monitor 4 events per CHA at a time, we need to
+        // program the counters in batches of 4. This loop will iterate over
+        // all events and program them in groups of 4.
+        int start_idx = batch * NUM_CTR_PER_CHA;
+        int num_events_to_program = (start_idx + NUM_CTR_PER_CHA > num_total_events)
+                                        ? num_total_events - start_idx
+                                        : NUM_CTR_PER_CHA;
+
+        char* event_group[NUM_CTR_PER_CHA];
+        for (int i = 0; i < num_events_to_program; i++) {
+            event_group[i] = event_name_list[start_idx + i];
+        }
+
+        phase_session(s->msr_fds, s->num_sockets, s->events, s->num_events, event_group,
+                      num_events_to_program, event_index);
+
+        printf("Monitoring session %d/%d: ", batch + 1, num_batches);
+        for (int i = 0; i < num_events_to_program; i++) {
+            printf("%s ", event_group[i]);
+        }
+        printf("\n");
+
+        // ------------------------------------------------------------------
+        // Set up a PMU monitoring session following documentation:
+        //
+        // Step (a): Freeze all uncore counters globally.
+        // Step (d): Reset counters in each box (done in configure_cha_counters).
+        // Step (b) & (c): Program event control registers and enable each monitor.
+        // Step (f): Unfreeze counters to begin counting.
+        // ------------------------------------------------------------------
+
+        // Step (a): Freeze counters globally before configuration.
+        freeze_counters_global(s->msr_fds, s->num_sockets);
+
+        // Baseline: the same measured window without the benchmark's ROI
+        for (int run = 0; s->baseline != BASELINE_NONE && run < s->warmup_runs + s->baseline_runs; run++) {
+            int slot = run < s->warmup_runs ? 0 : run - s->warmup_runs;
+            configure_cha_counters(s->msr_fds, s->num_sockets, s->events, s->num_events,
+                                   event_group, num_events_to_program);
+            if (s->baseline == BASELINE_INIT) {
+                ctx->run = slot;
+                benchmark->init(ctx);
+            }
+            unfreeze_counters_global(s->msr_fds, s->num_sockets);
+            baseline_roi(ctx);
+            freeze_counters_global(s->msr_fds, s->num_sockets);
+            if (s->baseline == BASELINE_INIT && benchmark->cleanup) {
+                benchmark->cleanup(ctx);
+            }
+            timing_discard_all();
+            read_cha_counters(s->msr_fds, s->num_sockets, s->events, s->num_events, event_group,
+                              num_events_to_program, slot, baseline_counts, event_index);
+        }
+        for (int i = 0; i < num_events_to_program; i++) {
+            baseline_runs_per_event[event_index + i] = s->baseline_runs;
+        }
+
+        // Monitoring session: perform measurements over s->runs iterations,
+        // or until the counts converge in adaptive mode. Warm-up runs are
+        // measured into the next slot and then overwritten.
+        int run_idx = 0;
+        for (int run = 0;; run++) {
+            // Steps (d), (b), (c): Reset counters and program event control
+            // registers. This call resets the counters in each CHA (by writing 0x3 to
+            // unit control registers) and then programs the control registers with
+            // enable (.en), event selection (.ev_sel) and umask bits for each
+            // requested event. Note: Currently U_MSR_PMON_UNIT_CTL_rst_both is
+            // working. if not, use delta calculation
+            configure_cha_counters(s->msr_fds, s->num_sockets, s->events, s->num_events,
+                                   event_group, num_events_to_program);
+
+            // Bench: Preconfigure the benchmark here
+            ctx->run = run_idx;
+            benchmark->init(ctx);
+
+            // Step (f): Unfreeze global counters to start counting.
+            phase_begin_run(run_idx);
+            unfreeze_counters_global(s->msr_fds, s->num_sockets);
+
+            // Bench: Run the benchmark here
+            benchmark->roi(ctx);
+
+            // Freeze counters to stop counting at the end of the monitoring interval.
+            freeze_counters_global(s->msr_fds, s->num_sockets);
+            if (run < s->warmup_runs) {
+                timing_discard_all();
+            } else {
+                timing_flush_all();
+            }
+
+            // Run cleanup (if available)
+            if (benchmark->cleanup) {
+                benchmark->cleanup(ctx);
+            }
+
+            // Read new counter values after measurement interval.
+            read_cha_counters(s->msr_fds, s->num_sockets, s->events, s->num_events, event_group,
+                              num_events_to_program, run_idx, new_counts, event_index);
+            phase_end_run(new_counts);
+
+            if (run < s->warmup_runs) continue;
+            run_idx++;
+            if (s->adaptive_width > 0
+                    ? run_idx >= s->max_runs || counts_converged(new_counts, run_idx, s->num_sockets, event_index,
+                                                                 num_events_to_program, s->adaptive_width)
+                    : run_idx >= s->runs) {
+                break;
+            }
+        }
+
+        for (int i = 0; i < num_events_to_program; i++) {
+            runs_per_event[event_index + i] = run_idx;
+        }
+        if (s->adaptive_width > 0 || s->warmup_runs > 0) {
+            printf("Monitoring session %d/%d: %d runs kept, %d warm-up discarded%s\n", batch + 1, num_batches,
+                   run_idx, s->warmup_runs,
+                   s->adaptive_width > 0 && run_idx >= s->max_runs ? " (run cap reached)" : "");
+        }
+
+        event_index += num_events_to_program;  // Move index forward
+    }
+
+    // Write event counts to output file.
+    write_event_counts(new_counts, runs_per_event, num_total_events, s->num_sockets, event_name_list,
+                       output_name);
+    write_session_layout(output_name);
+    for (int phase = 0; num_phases > 1 && phase < num_phases; phase++) {
+        char phase_name[300];
+        snprintf(phase_name, sizeof(phase_name), "%s_phase%d", output_name, phase);
+        write_event_counts(phase_counts[phase], runs_per_event, num_total_events, s->num_sockets,
+                           event_name_list, phase_name);
+    }
+    if (s->baseline != BASELINE_NONE) {
+        write_baseline_report(new_counts, runs_per_event, baseline_counts, baseline_runs_per_event,
+                              num_total_events, s->num_sockets, event_name_list, output_name,
+                              baseline_names[s->baseline]);
+    }
+    bench_print_metrics(ctx);
+    timing_report_all(stdout);
+    if (benchmark->teardown) {
+        benchmark->teardown(ctx);
+    }
+    return 0;
+}
@@ -0,0 +1,339 @@
+#include <string.h>
+#include "slice_alloc.h"
+
+typedef struct {
+    void **lines;         // Every line owned by this slice
+    void **free_list;     // LIFO stack of free lines
+    size_t capacity;
+    size_t free_count;
+    size_t in_use;
+    size_t peak_in_use;
+    size_t allocs;
+    size_t frees;
+    size_t failed;
+} slice_pool_t;
+
+// Open-addressed table mapping a line back to its owning slice
+typedef struct {
+    uintptr_t line;
+    short socket_id;
+    short cha;
+    int live;
+} slice_owner_t;
+
+static slice_pool_t pools[MAX_SOCKETS][NUM_CHA];
+static slice_owner_t *owners = NULL;
+static size_t owner_slots = 0;
+static size_t owner_count = 0;
+static int nearest_cha_cache[MAX_SOCKETS][SLICE_MAX_CORES];
+static int nearest_cha_cache_valid = 0;
+
+static size_t owner_hash(uintptr_t line) {
+    return (size_t)((line / CACHE_LINE_SIZE) * 0x9E3779B97F4A7C15ULL);
+}
+
+static slice_owner_t *owner_find(uintptr_t line) {
+    if (!owners) return NULL;
+    size_t mask = owner_slots - 1;
+    for (size_t i = owner_hash(line) & mask;; i = (i + 1) & mask) {
+        if (owners[i].line == line) return &owners[i];
+        if (owners[i].line == 0) return NULL;
+    }
+}
+
+static int owner_insert(uintptr_t line, int socket_id, int cha);
+
+static int owner_grow() {
+    size_t new_slots = owner_slots ? owner_slots * 2 : 4096;
+    slice_owner_t *old = owners;
+    size_t old_slots = owner_slots;
+
+    owners = calloc(new_slots, sizeof(slice_owner_t));
+    if (!owners) {
+        perror("calloc");
+        owners = old;
+        return -1;
+    }
+    owner_slots = new_slots;
+    owner_count = 0;
+
+    for (size_t i = 0; i < old_slots; i++) {
+        if (old[i].line) {
+            owner_insert(old[i].line, old[i].socket_id, old[i].cha);
+            owner_find(old[i].line)->live = old[i].live;
+        }
+    }
+    free(old);
+    return 0;
+}
+
+static int owner_insert(uintptr_t line, int socket_id, int cha) {
+    // Keep the load factor under one half
+    if ((owner_count + 1) * 2 > owner_slots && owner_grow() != 0) return -1;
+
+    size_t mask = owner_slots - 1;
+    size_t i = owner_hash(line) & mask;
+    while (owners[i].line != 0) {
+        if (owners[i].line == line) return 1;  // Already owned
+        i = (i + 1) & mask;
+    }
+    owners[i].line = line;
+    owners[i].socket_id = socket_id;
+    owners[i].cha = cha;
+    owners[i].live = 0;
+    owner_count++;
+    return 0;
+}
+
+int slice_alloc_add_lines(int socket_id, int cha, void **lines, int count) {
+    if (socket_id < 0 || socket_id >= MAX_SOCKETS || cha < 0 || cha >= NUM_CHA) {
+        fprintf(stderr, "Invalid slice (socket %d, CHA %d)\n", socket_id, cha);
+        return -1;
+    }
+
+    slice_pool_t *pool = &pools[socket_id][cha];
+    size_t new_capacity = pool->capacity + count;
+    void **new_lines = realloc(pool->lines, new_capacity * sizeof(void*));
+    void **new_free = realloc(pool->free_list, new_capacity * sizeof(void*));
+    if (!new_lines || !new_free) {
+        perror("realloc");
+        if (new_lines) pool->lines = new_lines;
+        if (new_free) pool->free_list = new_free;
+        return -1;
+    }
+    pool->lines = new_lines;
+    pool->free_list = new_free;
+
+    int added = 0;
+    for (int i = 0; i < count; i++) {
+        uintptr_t line = (uintptr_t)lines[i] & ~((uintptr_t)CACHE_LINE_SIZE - 1);
+        if (!line || owner_insert(line, socket_id, cha) != 0) continue;
+
+        pool->lines[pool->capacity] = (void*)line;
+        pool->free_list[pool->free_count++] = (void*)line;
+        pool->capacity++;
+        added++;
+    }
+    return added;
+}
+
+int slice_alloc_init(const addr_pool_t *pool, int socket_id) {
+    if (socket_id < 0 || socket_id >= pool->num_sockets) {
+        fprintf(stderr, "Invalid socket ID: %d\n", socket_id);
+        return -1;
+    }
+
+    if (!nearest_cha_cache_valid) {
+        memset(nearest_cha_cache, -1, sizeof(nearest_cha_cache));
+        nearest_cha_cache_valid = 1;
+    }
+
+    int total = 0;
+    for (int cha = 0; cha < NUM_CHA; cha++) {
+        const pool_list_t *list = pool_list(pool, socket_id, cha);
+        if (list->count == 0) continue;
+
+        void **lines = malloc(list->count * sizeof(void*));
+        if (!lines) {
+            perror("malloc");
+            return -1;
+        }
+        for (uint32_t i = 0; i < list->count; i++) {
+            lines[i] = pool_line(list, i);
+        }
+
+        int added = slice_alloc_add_lines(socket_id, cha, lines, list->count);
+        if (added > 0) total += added;
+        free(lines);
+    }
+
+    DEBUG_PRINT("Slice allocator: %d lines on socket %d", total, socket_id);
+    return total;
+}
+
+void slice_alloc_destroy() {
+    for (int s = 0; s < MAX_SOCKETS; s++) {
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            free(pools[s][cha].lines);
+            free(pools[s][cha].free_list);
+        }
+    }
+    memset(pools, 0, sizeof(pools));
+
+    free(owners);
+    owners = NULL;
+    owner_slots = 0;
+    owner_count = 0;
+    nearest_cha_cache_valid = 0;
+}
+
+void *slice_alloc(int socket_id, int cha) {
+    if (socket_id < 0 || socket_id >= MAX_SOCKETS || cha < 0 || cha >= NUM_CHA) {
+        return NULL;
+    }
+
+    slice_pool_t *pool = &pools[socket_id][cha];
+    if (pool->free_count == 0) {
+        pool->failed++;
+        return NULL;
+    }
+
+    void *line = pool->free_list[--pool->free_count];
+    owner_find((uintptr_t)line)->live = 1;
+
+    pool->allocs++;
+    pool->in_use++;
+    if (pool->in_use > pool->peak_in_use) pool->peak_in_use = pool->in_use;
+    return line;
+}
+
+void *slice_alloc_near_core(int socket_id, int core_id) {
+    int cha = slice_nearest_cha(socket_id, core_id);
+    if (cha < 0) return NULL;
+    return slice_alloc(socket_id, cha);
+}
+
+void slice_free(void *ptr) {
+    if (!ptr) return;
+
+    slice_owner_t *owner = owner_find((uintptr_t)ptr);
+    if (!owner || (uintptr_t)ptr != owner->line) {
+        fprintf(stderr, "slice_free: %p was not allocated by the slice allocator\n", ptr);
+        return;
+    }
+    if (!owner->live) {
+        fprintf(stderr, "slice_free: double free of %p\n", ptr);
+        return;
+    }
+
+    slice_pool_t *pool = &pools[owner->socket_id][owner->cha];
+    owner->live = 0;
+    pool->free_list[pool->free_count++] = ptr;
+    pool->in_use--;
+    pool->frees++;
+}
+
+// Locate the CHA with the lowest LLC hit latency from core_id. Lines of each
+// slice are made LLC resident (loaded, then pushed out of L1/L2) and timed.
+int slice_nearest_cha(int socket_id, int core_id) {
+    if (socket_id < 0 || socket_id >= MAX_SOCKETS || core_id < 0 || core_id >= SLICE_MAX_CORES) {
+        return -1;
+    }
+    if (!nearest_cha_cache_valid) {
+        memset(nearest_cha_cache, -1, sizeof(nearest_cha_cache));
+        nearest_cha_cache_valid = 1;
+    }
+    if (nearest_cha_cache[socket_id][core_id] >= 0) {
+        return nearest_cha_cache[socket_id][core_id];
+    }
+
+    cpu_set_t old_set;
+    sched_getaffinity(0, sizeof(old_set), &old_set);
+    set_process_affinity(core_id);
+
+    int best_cha = -1;
+    uint64_t best_latency = UINT64_MAX;
+
+    for (int cha = 0; cha < NUM_CHA; cha++) {
+        slice_pool_t *pool = &pools[socket_id][cha];
+        int n = pool->capacity < SLICE_PROBE_LINES ? (int)pool->capacity : SLICE_PROBE_LINES;
+        if (n == 0) continue;
+
+        uint64_t line_min[SLICE_PROBE_LINES];
+        for (int i = 0; i < n; i++) line_min[i] = UINT64_MAX;
+
+        for (int rep = 0; rep < SLICE_PROBE_REPS; rep++) {
+            for (int i = 0; i < n; i++) {
+                maccess(pool->lines[i]);
+            }
+            evict_private_caches();
+
+            for (int i = 0; i < n; i++) {
+                uint64_t start = rdtsc();
+                maccess(pool->lines[i]);
+                uint64_t end = rdtsc();
+                if (end - start < line_min[i]) line_min[i] = end - start;
+            }
+        }
+
+        // Median of the per-line minima
+        for (int i = 1; i < n; i++) {
+            uint64_t v = line_min[i];
+            int j = i - 1;
+            while (j >= 0 && line_min[j] > v) {
+                line_min[j + 1] = line_min[j];
+                j--;
+            }
+            line_min[j + 1] = v;
+        }
+        uint64_t latency = line_min[n / 2];
+
+        DEBUG_PRINT("Core %d -> CHA %d: %lu cycles", core_id, cha, latency);
+        if (latency < best_latency) {
+            best_latency = latency;
+            best_cha = cha;
+        }
+    }
+
+    sched_setaffinity(0, sizeof(old_set), &old_set);
+
+    nearest_cha_cache[socket_id][core_id] = best_cha;
+    return best_cha;
+}
+
+static int compare_uintptr(const void *a, const void *b) {
+    uintptr_t x = *(const uintptr_t*)a, y = *(const uintptr_t*)b;
+    return (x > y) - (x < y);
+}
+
+void slice_alloc_get_stats(int socket_id, int cha, slice_alloc_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (socket_id < 0 || socket_id >= MAX_SOCKETS || cha < 0 || cha >= NUM_CHA) return;
+
+    slice_pool_t *pool = &pools[socket_id][cha];
+    stats->capacity = pool->capacity;
+    stats->free = pool->free_count;
+    stats->in_use = pool->in_use;
+    stats->peak_in_use = pool->peak_in_use;
+    stats->allocs = pool->allocs;
+    stats->frees = pool->frees;
+    stats->failed = pool->failed;
+
+    if (pool->in_use == 0) return;
+
+    // Count distinct pages spanned by live objects
+    uintptr_t *pages = malloc(pool->in_use * sizeof(uintptr_t));
+    if (!pages) return;
+
+    size_t n = 0;
+    for (size_t i = 0; i < pool->capacity; i++) {
+        slice_owner_t *owner = owner_find((uintptr_t)pool->lines[i]);
+        if (owner && owner->live && n < pool->in_use) {
+            pages[n++] = owner->line / PAGE_SIZE;
+        }
+    }
+    qsort(pages, n, sizeof(uintptr_t), compare_uintptr);
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0 || pages[i] != pages[i - 1]) stats->pages_in_use++;
+    }
+    free(pages);
+}
+
+void slice_alloc_print_stats(int socket_id, FILE *fp) {
+    size_t total_free = 0;
+    for (int cha = 0; cha < NUM_CHA; cha++) total_free += pools[socket_id][cha].free_count;
+
+    fprintf(fp, "Slice allocator statistics (socket %d, %zu free lines)\n", socket_id, total_free);
+    fprintf(fp, "%-5s %8s %8s %8s %8s %8s %8s %8s %10s\n",
+            "CHA", "Cap", "Free", "InUse", "Peak", "Allocs", "Failed", "Pages", "Lines/Pg");
+    for (int cha = 0; cha < NUM_CHA; cha++) {
+        slice_alloc_stats_t st;
+        slice_alloc_get_stats(socket_id, cha, &st);
+        if (st.capacity == 0) continue;
+
+        double density = st.pages_in_use ? (double)st.in_use / st.pages_in_use : 0.0;
+        fprintf(fp, "%-5d %8zu %8zu %8zu %8zu %8zu %8zu %8zu %10.2f\n",
+                cha, st.capacity, st.free, st.in_use, st.peak_in_use,
+                st.allocs, st.failed, st.pages_in_use, density);
+    }
+}
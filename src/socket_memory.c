@@ -1,58 +1,268 @@
 #include <inttypes.h>
+#include <string.h>
+#include <time.h>
 #include "socket_memory.h"
+#include "actor.h"
 
-void* address_list[MAX_SOCKETS][NUM_CHA][MAX_ADDRESSES] = {{{NULL}}};
+addr_pool_t address_pool = {0};
 uint8_t *socket_buffers[MAX_SOCKETS] = {NULL};
+uint8_t *node_buffers[MAX_NODES] = {NULL};
+int cha_node[MAX_SOCKETS][NUM_CHA];
+
+// How each node buffer was obtained, so it can be released with munmap
+static void *node_raw_buffers[MAX_NODES] = {NULL};
+static size_t node_raw_lengths[MAX_NODES] = {0};
+static size_t node_page_sizes[MAX_NODES] = {0};
+
+static volatile long touched_pages = 0;  // 4KB units first-touched so far
+
+typedef struct {
+    uint8_t *buffer;
+    size_t begin;
+    size_t end;
+    size_t page_size;
+    int cpu;
+} touch_task_t;
+
+// Fall back to one node per socket when sysfs has no node information
+static void assume_node_per_socket() {
+    int max_nodes = numa_max_node() + 1;
+    if (max_nodes > MAX_SOCKETS) {
+        max_nodes = MAX_SOCKETS;
+    }
+
+    num_nodes = max_nodes;
+    for (int node = 0; node < max_nodes; node++) {
+        node_socket[node] = node;
+        socket_nodes[node][0] = node;
+        socket_num_nodes[node] = 1;
+    }
+}
+
+static double elapsed_seconds(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Free hugetlb pages of the given size on a node. Reservations made by mmap
+// are not per node, so a bound mapping could otherwise fault with SIGBUS.
+static long node_free_hugepages(int node, size_t page_size) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/hugepages/hugepages-%zukB/free_hugepages",
+             node, page_size >> 10);
+    FILE *file = fopen(path, "r");
+    if (!file) return 0;
+
+    long free_pages = 0;
+    if (fscanf(file, "%ld", &free_pages) != 1) free_pages = 0;
+    fclose(file);
+    return free_pages;
+}
+
+// Map BUFFER_SIZE bytes for a node, preferring 1GB then 2MB hugetlbfs pages
+// and falling back to 4KB pages with transparent hugepages requested.
+static uint8_t *map_node_buffer_pages(int node) {
+    static const struct {
+        int flags;
+        size_t page_size;
+        const char *name;
+    } kinds[] = {
+        {MAP_HUGETLB | MAP_HUGE_1GB, 1UL << 30, "1GB hugetlb"},
+        {MAP_HUGETLB | MAP_HUGE_2MB, 2UL << 20, "2MB hugetlb"},
+    };
+
+    for (int k = 0; k < USE_HUGEPAGES * (int)(sizeof(kinds) / sizeof(kinds[0])); k++) {
+        if (node_free_hugepages(node, kinds[k].page_size) < (long)(BUFFER_SIZE / kinds[k].page_size)) {
+            continue;
+        }
+
+        void *mem = mmap(NULL, BUFFER_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | kinds[k].flags, -1, 0);
+        if (mem == MAP_FAILED) continue;
+
+        node_raw_buffers[node] = mem;
+        node_raw_lengths[node] = BUFFER_SIZE;
+        node_page_sizes[node] = kinds[k].page_size;
+        printf("Node %d: %s pages\n", node, kinds[k].name);
+        return mem;
+    }
+
+    void *mem = mmap(NULL, BUFFER_SIZE + ALIGNMENT, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return NULL;
+
+    // Ensure 2MB alignment
+    uintptr_t aligned_addr = ((uintptr_t)mem + (ALIGNMENT - 1)) & ~(ALIGNMENT - 1);
+    madvise((void *)aligned_addr, BUFFER_SIZE, MADV_HUGEPAGE);
+
+    node_raw_buffers[node] = mem;
+    node_raw_lengths[node] = BUFFER_SIZE + ALIGNMENT;
+    node_page_sizes[node] = PAGE_SIZE;
+    printf("Node %d: 4KB pages (hugetlb unavailable, THP requested)\n", node);
+    return (uint8_t *)aligned_addr;
+}
+
+static void *first_touch_worker(void *arg) {
+    touch_task_t *task = arg;
+
+    if (task->cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(task->cpu, &cpuset);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    }
+
+    long pages_per_touch = task->page_size / PAGE_SIZE;
+    for (size_t off = task->begin; off < task->end; off += task->page_size) {
+        task->buffer[off] = 0;  // Enforce allocation
+        __atomic_fetch_add(&touched_pages, pages_per_touch, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+// Query (not move) the node of one address per 2MB and count misplacements
+static long verify_node_placement(uint8_t *buffer, int node) {
+    size_t count = BUFFER_SIZE / ALIGNMENT;
+    void **pages = malloc(count * sizeof(void *));
+    int *status = malloc(count * sizeof(int));
+    if (!pages || !status) {
+        free(pages);
+        free(status);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        pages[i] = buffer + i * ALIGNMENT;
+    }
+
+    long misplaced = 0;
+    if (move_pages(0, count, pages, NULL, status, 0) != 0) {
+        perror("move_pages");
+        misplaced = -1;
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            if (status[i] != node) misplaced++;
+        }
+    }
 
+    free(pages);
+    free(status);
+    return misplaced;
+}
+
+// Allocate BUFFER_SIZE on every NUMA node that belongs to a socket. With SNC
+// enabled a socket has several nodes; socket_buffers[] keeps pointing at the
+// first node of each socket. Buffers are bound to their node with mbind and
+// first-touched in parallel by threads pinned to that node's CPUs.
 void allocate_memory_per_socket() {
     if (numa_available() < 0) {
         fprintf(stderr, "NUMA is not available on this system.\n");
         return;
     }
 
-    int max_nodes = numa_max_node() + 1;
-    if (max_nodes > MAX_SOCKETS) {
-        max_nodes = MAX_SOCKETS;
+    if (num_nodes == 0 && discover_numa_topology() <= 0) {
+        assume_node_per_socket();
     }
+    print_numa_topology();
 
-    int total_pages = (BUFFER_SIZE / PAGE_SIZE) * max_nodes; // Total pages across all sockets
-    int processed_pages = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
-    for (int socket_id = 0; socket_id < max_nodes; socket_id++) {
-        void *raw_mem = numa_alloc_onnode(BUFFER_SIZE + ALIGNMENT, socket_id);
-        if (!raw_mem) {
-            fprintf(stderr, "Memory allocation failed on socket %d\n", socket_id);
-            continue;
-        }
+    touch_task_t tasks[MAX_NODES * FIRST_TOUCH_THREADS];
+    pthread_t threads[MAX_NODES * FIRST_TOUCH_THREADS];
+    int num_tasks = 0;
+    long total_pages = 0;
 
-        // Ensure 4MB alignment
-        uintptr_t aligned_addr = ((uintptr_t)raw_mem + (ALIGNMENT - 1)) & ~(ALIGNMENT - 1);
-        uint8_t *buffer = (uint8_t *)aligned_addr;
+    for (int socket_id = 0; socket_id < MAX_SOCKETS; socket_id++) {
+        for (int i = 0; i < socket_num_nodes[socket_id]; i++) {
+            int node = socket_nodes[socket_id][i];
+
+            uint8_t *buffer = map_node_buffer_pages(node);
+            if (!buffer) {
+                fprintf(stderr, "Memory allocation failed on node %d (socket %d)\n", node, socket_id);
+                continue;
+            }
+
+            unsigned long nodemask[(MAX_NODES + 63) / 64] = {0};
+            nodemask[node / 64] |= 1UL << (node % 64);
+            if (mbind(buffer, BUFFER_SIZE, MPOL_BIND, nodemask, MAX_NODES + 1, 0) != 0) {
+                perror("mbind");
+            }
+
+            node_buffers[node] = buffer;
+            if (!socket_buffers[socket_id]) {
+                socket_buffers[socket_id] = buffer;
+            }
+            total_pages += BUFFER_SIZE / PAGE_SIZE;
 
-        // Access every 4KB of allocated memory and show progress
-        for (size_t i = 0; i < BUFFER_SIZE; i += PAGE_SIZE) {
-            buffer[i] = 0;  // Enforce allocation
-            
-            processed_pages++;
-            display_progress("Memory Allocation:", processed_pages, total_pages);
+            // CPUs of this node, used round-robin by the touch threads
+            int cpus[FIRST_TOUCH_THREADS];
+            int num_cpus = 0;
+            for (int cpu = 0; cpu < MAX_CPUS && num_cpus < FIRST_TOUCH_THREADS; cpu++) {
+                if (cpu_node[cpu] == node) cpus[num_cpus++] = cpu;
+            }
+
+            size_t page_size = node_page_sizes[node];
+            size_t num_pages = BUFFER_SIZE / page_size;
+            int workers = num_pages < FIRST_TOUCH_THREADS ? (int)num_pages : FIRST_TOUCH_THREADS;
+            for (int w = 0; w < workers; w++) {
+                touch_task_t *task = &tasks[num_tasks];
+                task->buffer = buffer;
+                task->begin = (num_pages * w / workers) * page_size;
+                task->end = (num_pages * (w + 1) / workers) * page_size;
+                task->page_size = page_size;
+                task->cpu = num_cpus ? cpus[w % num_cpus] : -1;
+
+                if (pthread_create(&threads[num_tasks], NULL, first_touch_worker, task) != 0) {
+                    perror("pthread_create");
+                    first_touch_worker(task);
+                    continue;
+                }
+                num_tasks++;
+            }
         }
+    }
 
-        socket_buffers[socket_id] = buffer;
+    // Progress is polled rather than reported per page
+    while (__atomic_load_n(&touched_pages, __ATOMIC_RELAXED) < total_pages) {
+        display_progress("Memory Allocation:", touched_pages / 256, total_pages / 256);
+        usleep(PROGRESS_INTERVAL_US);
+    }
+    for (int t = 0; t < num_tasks; t++) {
+        pthread_join(threads[t], NULL);
     }
 
     // Ensure progress bar reaches 100% at the end
     display_progress("Memory Allocation:", total_pages, total_pages);
     printf("\n");
+
+    for (int node = 0; node < MAX_NODES; node++) {
+        if (!node_buffers[node]) continue;
+        long misplaced = verify_node_placement(node_buffers[node], node);
+        if (misplaced > 0) {
+            fprintf(stderr, "Warning: %ld of %ld sampled pages of node %d are on another node\n",
+                    misplaced, (long)(BUFFER_SIZE / ALIGNMENT), node);
+        }
+    }
+
+    printf("Memory allocation: %ld MB on %d threads in %.2f s\n",
+           total_pages * PAGE_SIZE >> 20, num_tasks, elapsed_seconds(&start));
 }
 
 
 void free_memory_per_socket() {
-    for (int socket_id = 0; socket_id < MAX_SOCKETS; socket_id++) {
-        if (socket_buffers[socket_id]) {
-            numa_free(socket_buffers[socket_id], BUFFER_SIZE);
-            socket_buffers[socket_id] = NULL;
+    for (int node = 0; node < MAX_NODES; node++) {
+        if (node_raw_buffers[node]) {
+            munmap(node_raw_buffers[node], node_raw_lengths[node]);
+            node_raw_buffers[node] = NULL;
+            node_buffers[node] = NULL;
         }
     }
+    for (int socket_id = 0; socket_id < MAX_SOCKETS; socket_id++) {
+        socket_buffers[socket_id] = NULL;
+    }
+    touched_pages = 0;
 }
 
 void *get_socket_buffer(int socket_id) {
@@ -82,43 +292,28 @@ void access_flush_socket_memory_one(int socket_id) {
 
 void access_socket_memory_hitmealloc(int socket_id) {
     void *buffer = get_socket_buffer(socket_id);
-    int p,q;
-    if (!buffer) {
-        fprintf(stderr, "Error: No allocated buffer for socket %d\n", socket_id);
-        return;
-    }
-    if (socket_id == 0) {
-        p = 1;
-        q = 2;
-    }
-    else if (socket_id == 1) {
-        p = 2;
-        q = 3;
-    }
-    else if (socket_id == 2) {
-        p = 3;
-        q = 0;
-    } else {
-        p = 0;
-        q = 1;
-    }
     if (!buffer) {
         fprintf(stderr, "Error: No allocated buffer for socket %d\n", socket_id);
         return;
     }
 
+    // Lines are read alternately from the primary cores of the next two sockets
+    int p = (socket_id + 1) % MAX_SOCKETS;
+    int q = (socket_id + 2) % MAX_SOCKETS;
+    actor_t *first = actor_get(primary_cores[p]);
+    actor_t *second = actor_get(primary_cores[q]);
 
     for (int cha = 0; cha < NUM_CHA; cha++) {
-        for (int addr = 0; addr < MAX_ADDRESSES; addr++) {
-            void* target = address_list[0][cha][addr];
-            set_process_affinity(primary_cores[p]);
-            maccess(target);  // Access the memory
-            mfence();         // Memory fence
-            set_process_affinity(primary_cores[q]);
-            maccess(target);  // Access the memory
-            mfence();         // Memory fence
+        const pool_list_t *list = pool_list(&address_pool, 0, cha);
+        for (uint32_t addr = 0; addr < list->count; addr++) {
+            actor_after(first, second);
+            actor_submit(first, ACTOR_READ, list, addr, 1);
+            actor_after(second, first);
+            actor_submit(second, ACTOR_READ, list, addr, 1);
         }
     }
+    actor_sync(first);
+    actor_sync(second);
 }
 
 // Function to determine which CHA an address belongs to across all sockets
@@ -176,6 +371,95 @@ void print_binary(uintptr_t value) {
     printf("\n");
 }
 
+// Scan one node buffer of a socket and fill address_pool for the CHAs that
+// home its memory. With SNC a node's memory is homed only at the CHAs of its
+// own cluster, so the scan stops once that domain (about NUM_CHA / nodes per
+// socket CHAs) is complete.
+static void map_node_buffer(int socket_id, int node, int* msr_fds, int num_sockets,
+                            cha_event_t* events, int num_events, FILE *log_file) {
+    uint8_t* buffer = node_buffers[node];
+    if (!buffer) {
+        fprintf(stderr, "Error: No allocated buffer for node %d (socket %d)\n", node, socket_id);
+        return;
+    }
+
+    int domain_estimate = NUM_CHA / socket_num_nodes[socket_id];
+    uint32_t cha_count[NUM_CHA] = {0};  // Keep track of found offsets per CHA
+    int foreign_lines = 0;         // Lines homed at a CHA already claimed by another node
+
+    for (int offset = 0; offset < BUFFER_SIZE;) {
+        if (offset + 64 > BUFFER_SIZE) break;
+
+        void* target = (char*)buffer + offset;
+        offset += 64;
+
+
+        // // Perform bitwise operation to ensure bits [16-6] are set to 0b00000011011
+        // uintptr_t target_addr = (uintptr_t)target;
+        // target_addr &= ~(((uintptr_t)0x3FF) << 6); // Clear bits [16-6]
+        // target_addr |= ((uintptr_t)TARGET_SET_MASK) << 6;     // Set bits [16-6] to 0b00000011011
+        // target = (void*)target_addr; // Assign modified address back to target
+        // // Calculate the offset for next iteration
+        // offset = (uintptr_t)target - (uintptr_t)buffer + 65536;
+        // if (offset >= BUFFER_SIZE) break;
+
+        // // Print target address in binary and highlight bits [16-6]
+        // printf("Modified target address: 0x%" PRIxPTR "\n", target_addr);
+        // printf("Binary representation: ");
+        // print_binary(target_addr);
+
+        int cha_id = find_cha_mapped_offset(target, msr_fds, num_sockets, events, num_events);
+        if (cha_id == -1) continue;
+
+        if (cha_node[socket_id][cha_id] == -1) {
+            cha_node[socket_id][cha_id] = node;
+        } else if (cha_node[socket_id][cha_id] != node) {
+            foreign_lines++;
+            continue;
+        }
+
+        if (cha_count[cha_id] < (uint32_t)pool_lines_per_cha) {
+            if (addr_pool_add(&address_pool, socket_id, cha_id, node, buffer, target) != 0) break;
+            cha_count[cha_id]++;
+
+            // Check if all CHA mappings of this domain are filled
+            int seen = 0, all_filled = 1;
+            for (int i = 0; i < NUM_CHA; i++) {
+                if (cha_node[socket_id][i] != node) continue;
+                seen++;
+                if (cha_count[i] < (uint32_t)pool_lines_per_cha) {
+                    all_filled = 0;
+                    break;
+                }
+            }
+            if (all_filled && seen >= domain_estimate) break;  // Move to the next node
+
+            // Update progress bar
+            int processed_addresses = 0;
+            for (int i = 0; i < NUM_CHA; i++) processed_addresses += cha_count[i];
+            int total_addresses = pool_lines_per_cha * domain_estimate;
+            display_progress("Find CHA Mapping: ", processed_addresses, total_addresses);
+            fflush(stdout);
+        }
+    }
+
+    if (foreign_lines > 0) {
+        fprintf(stderr, "\nWarning: %d lines of node %d were homed at CHAs of another node\n",
+                foreign_lines, node);
+    }
+
+    // Offsets are relative to the node buffer
+    for (int i = 0; i < NUM_CHA; i++) {
+        if (cha_node[socket_id][i] != node) continue;
+        const pool_list_t *list = pool_list(&address_pool, socket_id, i);
+        fprintf(log_file, "CHA %d on Socket %d (Node %d):\n", i, socket_id, node);
+        for (uint32_t j = 0; j < list->count; j++) {
+            fprintf(log_file, "Offset: %u\n", list->offsets[j]);
+        }
+    }
+    fflush(log_file);
+}
+
 void generate_cha_mapped_offsets(int* msr_fds, int num_sockets, cha_event_t* events, int num_events) {
     FILE *log_file = fopen(OFFSET_FILE, "w");
     if (!log_file) {
@@ -183,90 +467,90 @@ void generate_cha_mapped_offsets(int* msr_fds, int num_sockets, cha_event_t* eve
         return;
     }
 
+    memset(cha_node, -1, sizeof(cha_node));
+    addr_pool_free(&address_pool);
+    addr_pool_init(&address_pool, num_sockets);
+
     for (int socket_id = 0; socket_id < num_sockets; socket_id++) {
-        // if (socket_id < 0) continue;
-        void* buffer = get_socket_buffer(socket_id);
-        if (!buffer) {
-            fprintf(stderr, "Error: No allocated buffer for socket %d\n", socket_id);
-            continue;
+        fflush(stdout);
+
+        for (int i = 0; i < socket_num_nodes[socket_id]; i++) {
+            map_node_buffer(socket_id, socket_nodes[socket_id][i], msr_fds, num_sockets,
+                            events, num_events, log_file);
         }
 
-        fflush(stdout);
+        // Ensure progress bar reaches 100% for each socket
+        display_progress("Find CHA Mapping: ", pool_lines_per_cha * NUM_CHA, pool_lines_per_cha * NUM_CHA);
+        printf("\n");
 
-        int cha_offset_list[NUM_CHA][MAX_ADDRESSES] = {0};  // Store offsets for each CHA
-        int cha_count[NUM_CHA] = {0};  // Keep track of found offsets per CHA
-
-        for (int offset = 0; offset < BUFFER_SIZE;) {
-            if (offset + 64 > BUFFER_SIZE) break;
-
-            void* target = (char*)buffer + offset;
-            offset += 64;
-
-
-            // // Perform bitwise operation to ensure bits [16-6] are set to 0b00000011011
-            // uintptr_t target_addr = (uintptr_t)target;
-            // target_addr &= ~(((uintptr_t)0x3FF) << 6); // Clear bits [16-6]
-            // target_addr |= ((uintptr_t)TARGET_SET_MASK) << 6;     // Set bits [16-6] to 0b00000011011
-            // target = (void*)target_addr; // Assign modified address back to target
-            // // Calculate the offset for next iteration
-            // offset = (uintptr_t)target - (uintptr_t)buffer + 65536;
-            // if (offset >= BUFFER_SIZE) break;
-            
-            // // Print target address in binary and highlight bits [16-6]
-            // printf("Modified target address: 0x%" PRIxPTR "\n", target_addr);
-            // printf("Binary representation: ");
-            // print_binary(target_addr);
-            
-            int cha_id = find_cha_mapped_offset(target, msr_fds, num_sockets, events, num_events);
-
-            if (cha_id != -1 && cha_count[cha_id] < MAX_ADDRESSES) {
-                // Check if this cha already has max_addresses
-                // if (cha_count[cha_id] >= MAX_ADDRESSES) {
-                //     continue;
-                // }
-                cha_offset_list[cha_id][cha_count[cha_id]] = offset;
-                address_list[socket_id][cha_id][cha_count[cha_id]] = target;  // Store actual address
-                cha_count[cha_id]++;
-
-                // Check if all CHA mappings are filled
-                int all_filled = 1;
-                for (int i = 0; i < NUM_CHA; i++) {
-                    if (cha_count[i] < MAX_ADDRESSES) {
-                        all_filled = 0;
-                        break;
-                    }
+        // Record which CHAs serve which SNC domain
+        if (socket_num_nodes[socket_id] > 1) {
+            for (int i = 0; i < socket_num_nodes[socket_id]; i++) {
+                int node = socket_nodes[socket_id][i];
+                printf("Socket %d, node %d CHAs:", socket_id, node);
+                for (int cha = 0; cha < NUM_CHA; cha++) {
+                    if (cha_node[socket_id][cha] == node) printf(" %d", cha);
                 }
+                printf("\n");
+            }
+        }
+        fflush(stdout);
+    }
 
-                // If all CHA mappings are found, write to the file and update global list
-                if (all_filled) {
-                    for (int i = 0; i < NUM_CHA; i++) {
-                        fprintf(log_file, "CHA %d on Socket %d:\n", i, socket_id);
-                        for (int j = 0; j < MAX_ADDRESSES; j++) {
-                            fprintf(log_file, "Offset: %d\n", cha_offset_list[i][j]);
-                        }
-                        fflush(log_file);
-                    }
-                    break;  // Move to the next socket
-                }
+    fclose(log_file);
+    addr_pool_finalize(&address_pool);
+    if (addr_pool_save(&address_pool, POOL_FILE) == 0) {
+        printf("\nCHA mapping completed. Results saved in %s and %s\n", OFFSET_FILE, POOL_FILE);
+    }
+    fflush(stdout);
+}
 
-                // Update progress bar
-                int processed_addresses = 0;
-                for (int i = 0; i < NUM_CHA; i++) processed_addresses += cha_count[i];
-                int total_addresses = MAX_ADDRESSES * NUM_CHA;
-                display_progress("Find CHA Mapping: ", processed_addresses, total_addresses);
-                fflush(stdout);
+// Rebuild cha_node from a loaded pool and re-check a few lines of every CHA
+// against the uncore counters. Returns 0 if the pool still matches this boot.
+int validate_address_pool(addr_pool_t *pool, int* msr_fds, int num_sockets, cha_event_t* events, int num_events) {
+    if (pool->num_sockets != num_sockets) {
+        fprintf(stderr, "Pool covers %d sockets, system has %d\n", pool->num_sockets, num_sockets);
+        return -1;
+    }
+
+    memset(cha_node, -1, sizeof(cha_node));
+    for (int socket_id = 0; socket_id < num_sockets; socket_id++) {
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            const pool_list_t *list = pool_list(pool, socket_id, cha);
+            if (list->count == 0) continue;
+            cha_node[socket_id][cha] = list->node;
+
+            uint32_t samples = list->count < MATCH_THRESHOLD ? list->count : MATCH_THRESHOLD;
+            for (uint32_t i = 0; i < samples; i++) {
+                void *target = pool_line(list, i * (list->count / samples));
+                if (find_cha_mapped_offset(target, msr_fds, num_sockets, events, num_events) != cha) {
+                    fprintf(stderr, "Pool mismatch: line %u of CHA %d (socket %d) moved\n", i, cha, socket_id);
+                    return -1;
+                }
             }
         }
+    }
+    return 0;
+}
 
-        // Ensure progress bar reaches 100% for each socket
-        display_progress("Find CHA Mapping: ", MAX_ADDRESSES * NUM_CHA, MAX_ADDRESSES * NUM_CHA);
-        printf("\n");
-        fflush(stdout);
+// Collect the CHAs of the pool with the requested locality for core_id.
+// pool_list(&address_pool, *socket_id, chas[i]) then holds the lines of that pool.
+int get_locality_chas(int core_id, pool_locality_t locality, int *socket_id, int chas[NUM_CHA]) {
+    int node = select_locality_node(core_id, locality);
+    if (node < 0) {
+        return 0;
     }
 
-    // fclose(log_file);
-    printf("\nCHA mapping completed. Results saved in %s\n", OFFSET_FILE);
-    fflush(stdout);
+    int socket = node_socket[node];
+    int count = 0;
+    for (int cha = 0; cha < NUM_CHA; cha++) {
+        if (cha_node[socket][cha] == node) {
+            chas[count++] = cha;
+        }
+    }
+
+    *socket_id = socket;
+    return count;
 }
 
 void access_flush_addresses(void* address_list_1d[], int num_addresses) {
@@ -285,3 +569,22 @@ void access_flush_addresses(void* address_list_1d[], int num_addresses) {
         }
     }
 }
+
+// Push the calling core's L1/L2 contents out to the LLC by streaming over a
+// scratch buffer twice the size of L2 (still far smaller than the LLC).
+void evict_private_caches() {
+    static uint8_t *scratch = NULL;
+    if (!scratch) {
+        scratch = aligned_alloc(PAGE_SIZE, 2 * L2_SIZE);
+        if (!scratch) {
+            perror("aligned_alloc");
+            return;
+        }
+    }
+
+    // Write rather than read: untouched pages would all alias the zero page
+    for (size_t i = 0; i < 2 * L2_SIZE; i += CACHE_LINE_SIZE) {
+        mmodify(scratch + i);
+    }
+    mfence();
+}
@@ -0,0 +1,101 @@
+#include <math.h>
+#include <stdio.h>
+#include "stats.h"
+
+run_stats_t run_stats(uint64_t counts[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS], int first, int n,
+                      int socket, int cha, int event) {
+    run_stats_t stats = {0, 0, n};
+    if (n <= 0) return stats;
+
+    double sum = 0;
+    for (int run = first; run < first + n; run++) {
+        sum += counts[run][socket][cha][event];
+    }
+    stats.mean = sum / n;
+    if (n < 2) return stats;
+
+    double sq = 0;
+    for (int run = first; run < first + n; run++) {
+        double d = counts[run][socket][cha][event] - stats.mean;
+        sq += d * d;
+    }
+    stats.sem = sqrt(sq / (n - 1) / n);
+    return stats;
+}
+
+// Two-sided 95% Student t quantile for n samples (n - 1 degrees of freedom)
+double t_critical_95(int n) {
+    static const double table[] = {
+        0, 0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+        2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+        2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045,
+    };
+    if (n < 2) return INFINITY;
+    return n < (int)(sizeof(table) / sizeof(table[0])) ? table[n] : 1.96;
+}
+
+// Whether the 95% confidence interval of every (socket, CHA) of events
+// [event_index, event_index + num_events) over runs [0, n) is at most
+// rel_width of its mean wide
+int counts_converged(uint64_t counts[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS], int n, int num_sockets,
+                     int event_index, int num_events, double rel_width) {
+    if (n < ADAPTIVE_MIN_RUNS) return 0;
+
+    double t = t_critical_95(n);
+    for (int event = event_index; event < event_index + num_events; event++) {
+        for (int socket = 0; socket < num_sockets; socket++) {
+            for (int cha = 0; cha < NUM_CHA; cha++) {
+                run_stats_t stats = run_stats(counts, 0, n, socket, cha, event);
+                double half_width = t * stats.sem;
+                if (half_width > ADAPTIVE_MIN_HALF_WIDTH && 2 * half_width > rel_width * stats.mean) {
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+// Measured, baseline and baseline-subtracted mean count per (event, socket,
+// CHA), with standard errors; the net error is the two added in quadrature.
+// Written to output/current/<benchmark>_baseline.log.
+void write_baseline_report(uint64_t counts[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS], const int runs[],
+                           uint64_t baseline[][MAX_SOCKETS][NUM_CHA][MAX_MONITOR_EVENTS], const int baseline_runs[],
+                           int num_events, int num_sockets, char **event_name_list, const char *benchmark_name,
+                           const char *mode) {
+    char path[512];
+    if (create_directory_recursively("output/current") != 0) return;
+    snprintf(path, sizeof(path), "output/current/%s_baseline.log", benchmark_name);
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        perror("Error opening baseline log");
+        return;
+    }
+    printf("Writing baseline-subtracted counts (%s baseline) to %s\n", mode, path);
+
+    for (int event = 0; event < num_events; event++) {
+        fprintf(fp, "\nEvent: %s (%d runs, %d baseline runs, %s baseline)\n", event_name_list[event], runs[event],
+                baseline_runs[event], mode);
+        fprintf(fp, "%-5s %-5s %12s %10s %12s %10s %12s %10s\n", "Soc", "CHA", "Measured", "+-", "Baseline", "+-",
+                "Net", "+-");
+
+        for (int socket = 0; socket < num_sockets; socket++) {
+            double net_total = 0, var_total = 0;
+            for (int cha = 0; cha < NUM_CHA; cha++) {
+                run_stats_t m = run_stats(counts, 0, runs[event], socket, cha, event);
+                run_stats_t b = run_stats(baseline, 0, baseline_runs[event], socket, cha, event);
+                double net = m.mean - b.mean;
+                double err = sqrt(m.sem * m.sem + b.sem * b.sem);
+                net_total += net;
+                var_total += err * err;
+                if (m.mean == 0 && b.mean == 0) continue;
+                fprintf(fp, "%-5d %-5d %12.2f %10.2f %12.2f %10.2f %12.2f %10.2f\n", socket, cha, m.mean, m.sem,
+                        b.mean, b.sem, net, err);
+            }
+            fprintf(fp, "%-5d %-5s %12s %10s %12s %10s %12.2f %10.2f\n", socket, "all", "", "", "", "", net_total,
+                    sqrt(var_total));
+        }
+    }
+    fclose(fp);
+}
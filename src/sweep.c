@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <jansson.h>
+#include <sys/utsname.h>
+#include "sweep.h"
+#include "stats.h"
+#include "util.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+typedef struct {
+    char key[sizeof(((bench_param_t *)0)->key)];
+    char values[MAX_SWEEP_VALUES][sizeof(((bench_param_t *)0)->value)];
+    int num_values;
+} sweep_axis_t;
+
+typedef struct {
+    char **names;
+    int count;
+    int valid;      // Every name is in the event catalog
+} sweep_group_t;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t len) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t fnv1a_str(uint64_t hash, const char *str) {
+    return fnv1a(hash, str, strlen(str) + 1);  // Keep the terminator so "ab","c" != "a","bc"
+}
+
+static int fnv1a_file(uint64_t *hash, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return -1;
+
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        *hash = fnv1a(*hash, buf, n);
+    }
+    fclose(fp);
+    return 0;
+}
+
+// CPU model, kernel and machine layout: results from another host or
+// kernel are not reused
+static uint64_t host_fingerprint(int num_sockets) {
+    uint64_t hash = FNV_OFFSET;
+    FILE *fp = fopen("/proc/cpuinfo", "r");
+    if (fp) {
+        char line[256];
+        int model = 0, microcode = 0;
+        while ((!model || !microcode) && fgets(line, sizeof(line), fp)) {
+            int *seen = strncmp(line, "model name", 10) == 0 ? &model
+                      : strncmp(line, "microcode", 9) == 0 ? &microcode : NULL;
+            if (seen && !*seen) {
+                hash = fnv1a_str(hash, line);
+                *seen = 1;
+            }
+        }
+        fclose(fp);
+    }
+
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        hash = fnv1a_str(hash, uts.nodename);
+        hash = fnv1a_str(hash, uts.release);
+        hash = fnv1a_str(hash, uts.machine);
+    }
+    int layout[2] = {num_sockets, NUM_CHA};
+    return fnv1a(hash, layout, sizeof(layout));
+}
+
+static void json_value_string(json_t *value, char *out, size_t size) {
+    if (json_is_string(value)) {
+        snprintf(out, size, "%s", json_string_value(value));
+    } else if (json_is_integer(value)) {
+        snprintf(out, size, "%lld", (long long)json_integer_value(value));
+    } else if (json_is_real(value)) {
+        snprintf(out, size, "%g", json_real_value(value));
+    } else {
+        snprintf(out, size, "%s", json_is_true(value) ? "1" : "0");
+    }
+}
+
+static int parse_axis(const char *key, json_t *spec, sweep_axis_t *axis) {
+    snprintf(axis->key, sizeof(axis->key), "%s", key);
+    axis->num_values = 0;
+
+    if (json_is_object(spec)) {
+        json_t *first = json_object_get(spec, "first");
+        json_t *last = json_object_get(spec, "last");
+        json_t *step = json_object_get(spec, "step");
+        if (!json_is_integer(first) || !json_is_integer(last)) {
+            fprintf(stderr, "Error: sweep range '%s' needs integer first and last\n", key);
+            return -1;
+        }
+        long long s = step ? json_integer_value(step) : 1;
+        if (s <= 0) {
+            fprintf(stderr, "Error: sweep range '%s' needs a positive step\n", key);
+            return -1;
+        }
+        for (long long v = json_integer_value(first); v <= json_integer_value(last); v += s) {
+            if (axis->num_values >= MAX_SWEEP_VALUES) {
+                fprintf(stderr, "Error: sweep range '%s' has more than %d values\n", key, MAX_SWEEP_VALUES);
+                return -1;
+            }
+            snprintf(axis->values[axis->num_values++], sizeof(axis->values[0]), "%lld", v);
+        }
+    } else if (json_is_array(spec)) {
+        size_t i;
+        json_t *value;
+        json_array_foreach(spec, i, value) {
+            if (axis->num_values >= MAX_SWEEP_VALUES) {
+                fprintf(stderr, "Error: sweep parameter '%s' has more than %d values\n", key, MAX_SWEEP_VALUES);
+                return -1;
+            }
+            json_value_string(value, axis->values[axis->num_values++], sizeof(axis->values[0]));
+        }
+    } else {
+        json_value_string(spec, axis->values[axis->num_values++], sizeof(axis->values[0]));
+    }
+
+    if (axis->num_values == 0) {
+        fprintf(stderr, "Error: sweep parameter '%s' has no values\n", key);
+        return -1;
+    }
+    return 0;
+}
+
+// Output names end up in paths; keep them to one directory level
+static void append_name(char *name, size_t size, const char *part) {
+    size_t len = strlen(name);
+    for (; *part && len + 1 < size; part++) {
+        char c = *part;
+        name[len++] = (c == '/' || c == ' ' || c == '=') ? '-' : c;
+    }
+    name[len] = '\0';
+}
+
+static uint64_t *load_checkpoint(const char *path, int *count) {
+    *count = 0;
+    FILE *fp = fopen(path, "r");
+    if (!fp) return NULL;
+
+    int capacity = 64;
+    uint64_t *hashes = malloc(capacity * sizeof(uint64_t));
+    char line[512];
+    while (hashes && fgets(line, sizeof(line), fp)) {
+        unsigned long long hash;
+        if (sscanf(line, "%llx", &hash) != 1) continue;  // Torn last line
+        if (*count == capacity) {
+            capacity *= 2;
+            uint64_t *grown = realloc(hashes, capacity * sizeof(uint64_t));
+            if (!grown) break;
+            hashes = grown;
+        }
+        hashes[(*count)++] = hash;
+    }
+    fclose(fp);
+    return hashes;
+}
+
+static int checkpointed(const uint64_t *hashes, int count, uint64_t hash) {
+    for (int i = 0; i < count; i++) {
+        if (hashes[i] == hash) return 1;
+    }
+    return 0;
+}
+
+int sweep_run(const char *path, const session_t *s, const bench_ctx_t *base,
+              char **event_name_list, int num_total_events) {
+    json_error_t error;
+    json_t *root = json_load_file(path, 0, &error);
+    if (!root) {
+        fprintf(stderr, "Error: %s:%d: %s\n", path, error.line, error.text);
+        return -1;
+    }
+
+    int ret = -1;
+    static sweep_axis_t axes[MAX_BENCH_PARAMS];
+    sweep_group_t groups[MAX_SWEEP_GROUPS];
+    int num_axes = 0, num_groups = 0;
+    uint64_t *done = NULL;
+    int num_done = 0;
+    FILE *checkpoint = NULL;
+
+    json_t *name_json = json_object_get(root, "name");
+    const char *sweep_name = json_is_string(name_json) ? json_string_value(name_json) : "sweep";
+    json_t *benchmarks = json_object_get(root, "benchmarks");
+    if (!json_is_array(benchmarks) || json_array_size(benchmarks) == 0) {
+        fprintf(stderr, "Error: %s: 'benchmarks' must be a non-empty list\n", path);
+        goto out;
+    }
+
+    // Points that need a bigger pool would all fail their setup
+    json_t *lines_per_cha = json_object_get(root, "lines_per_cha");
+    if (json_is_integer(lines_per_cha) && pool_lines_per_cha < json_integer_value(lines_per_cha)) {
+        fprintf(stderr, "Error: %s needs --lines-per-cha %lld or more\n", path,
+                (long long)json_integer_value(lines_per_cha));
+        goto out;
+    }
+
+    const char *key;
+    json_t *spec;
+    json_object_foreach(json_object_get(root, "params"), key, spec) {
+        if (num_axes >= MAX_BENCH_PARAMS) {
+            fprintf(stderr, "Error: %s: more than %d sweep parameters\n", path, MAX_BENCH_PARAMS);
+            goto out;
+        }
+        if (parse_axis(key, spec, &axes[num_axes++]) != 0) goto out;
+    }
+
+    json_t *events = json_object_get(root, "events");
+    if (json_is_array(events)) {
+        size_t i;
+        json_t *group;
+        json_array_foreach(events, i, group) {
+            if (num_groups >= MAX_SWEEP_GROUPS) {
+                fprintf(stderr, "Error: %s: more than %d event groups\n", path, MAX_SWEEP_GROUPS);
+                goto out;
+            }
+            if (!json_is_array(group) || json_array_size(group) == 0 ||
+                json_array_size(group) > MAX_MONITOR_EVENTS) {
+                fprintf(stderr, "Error: %s: event group %zu must list 1 to %d events\n", path, i,
+                        MAX_MONITOR_EVENTS);
+                goto out;
+            }
+            sweep_group_t *g = &groups[num_groups++];
+            g->count = 0;
+            g->names = calloc(MAX_MONITOR_EVENTS, sizeof(char *));
+            if (!g->names) {
+                perror("calloc");
+                goto out;
+            }
+            size_t j;
+            json_t *event;
+            json_array_foreach(group, j, event) {
+                if (!json_is_string(event)) {
+                    fprintf(stderr, "Error: %s: event %zu of group %zu is not a name\n", path, j, i);
+                    goto out;
+                }
+                g->names[g->count++] = strdup(json_string_value(event));
+            }
+        }
+    } else {
+        groups[num_groups++] = (sweep_group_t){event_name_list, num_total_events};
+    }
+    for (int g = 0; g < num_groups; g++) {
+        groups[g].valid = session_check_events(s, groups[g].names, groups[g].count) == 0;
+        if (!groups[g].valid) {
+            fprintf(stderr, "Error: %s: event group %d has unknown events, its points fail\n", path, g);
+        }
+    }
+
+    char checkpoint_name[128] = "", checkpoint_path[512];
+    append_name(checkpoint_name, sizeof(checkpoint_name), sweep_name);
+    snprintf(checkpoint_path, sizeof(checkpoint_path), "%s/%s.checkpoint", SWEEP_OUTPUT_DIR, checkpoint_name);
+    if (create_directory_recursively(SWEEP_OUTPUT_DIR) != 0) goto out;
+    done = load_checkpoint(checkpoint_path, &num_done);
+    checkpoint = fopen(checkpoint_path, "a");
+    if (!checkpoint) {
+        perror("Error opening sweep checkpoint");
+        goto out;
+    }
+
+    // Everything but the benchmark, parameters and events
+    uint64_t common = host_fingerprint(s->num_sockets);
+    int options[5] = {s->runs, s->warmup_runs, s->max_runs, s->baseline, s->baseline_runs};
+    common = fnv1a(common, options, sizeof(options));
+    common = fnv1a(common, &s->adaptive_width, sizeof(s->adaptive_width));
+    common = fnv1a(common, &pool_lines_per_cha, sizeof(pool_lines_per_cha));
+    for (int i = 0; i < base->num_params; i++) {
+        common = fnv1a_str(common, base->params[i].key);
+        common = fnv1a_str(common, base->params[i].value);
+    }
+
+    long num_points = 1;
+    for (int a = 0; a < num_axes; a++) num_points *= axes[a].num_values;
+    int ran = 0, skipped = 0, failed = 0;
+
+    size_t b;
+    json_t *bench_name;
+    json_array_foreach(benchmarks, b, bench_name) {
+        const BenchmarkV2 *benchmark = json_is_string(bench_name)
+                                           ? load_benchmark(json_string_value(bench_name)) : NULL;
+        if (!benchmark) {
+            fprintf(stderr, "Error: sweep benchmark %zu not found, skipping\n", b);
+            failed++;
+            continue;
+        }
+        uint64_t bench_hash = fnv1a_str(common, benchmark->name);
+        int hashed = fnv1a_file(&bench_hash, benchmark_source(benchmark)) == 0;
+        if (!hashed) {
+            fprintf(stderr, "Warning: cannot read %s, its points are always run\n", benchmark_source(benchmark));
+        }
+
+        for (long point = 0; point < num_points; point++) {
+            for (int g = 0; g < num_groups; g++) {
+                bench_ctx_t ctx;
+                bench_ctx_init(&ctx, benchmark, base->pool, base->num_sockets);
+                for (int i = 0; i < base->num_params; i++) {
+                    bench_param_set(&ctx, base->params[i].key, base->params[i].value);
+                }
+
+                char output_name[256] = "";
+                append_name(output_name, sizeof(output_name), sweep_name);
+                append_name(output_name, sizeof(output_name), "_");
+                append_name(output_name, sizeof(output_name), benchmark->name);
+
+                uint64_t hash = bench_hash;
+                long rest = point;
+                for (int a = 0; a < num_axes; a++) {
+                    const char *value = axes[a].values[rest % axes[a].num_values];
+                    rest /= axes[a].num_values;
+                    bench_param_set(&ctx, axes[a].key, value);
+                    hash = fnv1a_str(hash, axes[a].key);
+                    hash = fnv1a_str(hash, value);
+                    append_name(output_name, sizeof(output_name), "_");
+                    append_name(output_name, sizeof(output_name), axes[a].key);
+                    append_name(output_name, sizeof(output_name), value);
+                }
+                for (int e = 0; e < groups[g].count; e++) {
+                    hash = fnv1a_str(hash, groups[g].names[e]);
+                }
+                if (num_groups > 1) {
+                    char suffix[16];
+                    snprintf(suffix, sizeof(suffix), "_g%d", g);
+                    append_name(output_name, sizeof(output_name), suffix);
+                }
+
+                if (!groups[g].valid) {
+                    failed++;
+                    continue;
+                }
+                if (hashed && checkpointed(done, num_done, hash)) {
+                    printf("Sweep: %s unchanged, skipping\n", output_name);
+                    skipped++;
+                    continue;
+                }
+
+                printf("Sweep: %s (point %ld/%ld, group %d/%d)\n", output_name, point + 1, num_points,
+                       g + 1, num_groups);
+                if (run_session(s, benchmark, &ctx, groups[g].names, groups[g].count, output_name) != 0) {
+                    failed++;
+                    continue;
+                }
+                ran++;
+
+                // On disk before the next point starts, so a crash loses at most the running one
+                fprintf(checkpoint, "%016llx %s\n", (unsigned long long)hash, output_name);
+                fflush(checkpoint);
+                fsync(fileno(checkpoint));
+            }
+        }
+    }
+
+    printf("Sweep %s: %d points run, %d unchanged, %d failed (checkpoint %s)\n", sweep_name, ran, skipped,
+           failed, checkpoint_path);
+    ret = failed ? -1 : 0;
+
+out:
+    if (checkpoint) fclose(checkpoint);
+    free(done);
+    for (int g = 0; g < num_groups; g++) {
+        if (groups[g].names == event_name_list) continue;
+        for (int e = 0; e < groups[g].count; e++) free(groups[g].names[e]);
+        free(groups[g].names);
+    }
+    json_decref(root);
+    return ret;
+}
@@ -0,0 +1,219 @@
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "timing.h"
+
+uint64_t timing_overhead[TIMING_NUM_MODES];
+double tsc_ghz = 0;
+
+static timing_buffer_t buffers[MAX_TIMING_BUFFERS];
+static int num_buffers = 0;     // Slots in use or released; released ones have no samples
+
+static const char *mode_names[] = {"lfence", "rdtscp", "cpuid"};
+
+// Cost of an empty begin/end pair: the minimum over many rounds
+static uint64_t calibrate(timing_mode_t mode) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < TIMING_CALIBRATION_ROUNDS; i++) {
+        uint64_t begin = timing_begin(mode);
+        uint64_t end = timing_end(mode);
+        if (end - begin < best) best = end - begin;
+    }
+    return best;
+}
+
+static uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// TSC frequency from CPUID leaf 0x15 (crystal ratio) or 0x16 (base
+// frequency), else measured against CLOCK_MONOTONIC_RAW
+static double discover_tsc_ghz() {
+    uint32_t a, b, c, d;
+    unsigned max_leaf = __get_cpuid_max(0, NULL);
+
+    if (max_leaf >= 0x15) {
+        __cpuid(0x15, a, b, c, d);
+        if (a && b && c) return (double)c * b / a / 1e9;
+    }
+    if (max_leaf >= 0x16) {
+        __cpuid(0x16, a, b, c, d);
+        if (a & 0xFFFF) return (a & 0xFFFF) / 1e3;
+    }
+
+    uint64_t ns_start = monotonic_ns();
+    uint64_t tsc_start = timing_begin(TIMING_LFENCE);
+    while (monotonic_ns() - ns_start < 50000000ull) {}
+    uint64_t tsc_end = timing_end(TIMING_LFENCE);
+    uint64_t ns_end = monotonic_ns();
+    return (double)(tsc_end - tsc_start) / (ns_end - ns_start);
+}
+
+// Calibrate the stamp overheads and find the TSC frequency; run on the
+// core that will take the stamps
+void timing_init() {
+    tsc_ghz = discover_tsc_ghz();
+    printf("Timing: TSC %.3f GHz, overhead", tsc_ghz);
+    for (int mode = 0; mode < TIMING_NUM_MODES; mode++) {
+        calibrate(mode);  // Warm up
+        timing_overhead[mode] = calibrate(mode);
+        printf(" %s %lu", mode_names[mode], timing_overhead[mode]);
+    }
+    printf(" cycles\n");
+}
+
+// Buffer for one recording thread, pre-faulted so recording never allocates
+// or faults. Buffers live until exit, or until the plugin that created them
+// is unloaded (timing_buffer_release_object).
+timing_buffer_t *timing_buffer_create(const char *label, timing_mode_t mode, uint32_t capacity) {
+    int slot = 0;
+    while (slot < num_buffers && buffers[slot].samples) slot++;
+    if (slot >= MAX_TIMING_BUFFERS) {
+        fprintf(stderr, "Error: no timing buffer left for %s (MAX_TIMING_BUFFERS %d)\n", label, MAX_TIMING_BUFFERS);
+        return NULL;
+    }
+
+    timing_buffer_t *buf = &buffers[slot];
+    memset(buf, 0, sizeof(*buf));
+    buf->samples = malloc((size_t)capacity * sizeof(timing_sample_t));
+    buf->label = strdup(label);
+    if (!buf->samples || !buf->label) {
+        perror("malloc");
+        free(buf->samples);
+        free((char *)buf->label);
+        memset(buf, 0, sizeof(*buf));
+        return NULL;
+    }
+    memset(buf->samples, 0, (size_t)capacity * sizeof(timing_sample_t));
+    buf->mode = mode;
+    buf->capacity = capacity;
+
+    // Remember which object asked, so its buffers can go when it is dlclosed
+    Dl_info info;
+    if (dladdr(__builtin_return_address(0), &info)) buf->owner = info.dli_fbase;
+    if (slot == num_buffers) num_buffers++;
+    return buf;
+}
+
+// Free the buffers created by the object (executable or plugin) that holds
+// addr; called before a plugin is dlclosed, as their flush callbacks and the
+// plugin's pointers to them die with it. Unreported samples are lost.
+void timing_buffer_release_object(const void *addr) {
+    Dl_info info;
+    if (!dladdr(addr, &info)) return;
+    for (int i = 0; i < num_buffers; i++) {
+        timing_buffer_t *buf = &buffers[i];
+        if (!buf->samples || buf->owner != info.dli_fbase) continue;
+        free(buf->samples);
+        free(buf->hist);
+        free((char *)buf->label);
+        memset(buf, 0, sizeof(*buf));
+    }
+}
+
+// Collect this buffer's samples into per-key latency histograms
+int timing_buffer_histograms(timing_buffer_t *buf) {
+    if (!buf->hist) buf->hist = calloc(1, sizeof(latency_hist_t));
+    if (!buf->hist) {
+        perror("calloc");
+        return -1;
+    }
+    return 0;
+}
+
+static int compare_samples(const void *a, const void *b) {
+    const timing_sample_t *x = a, *y = b;
+    if (x->key >> 16 != y->key >> 16) return x->key >> 16 < y->key >> 16 ? -1 : 1;
+    return (x->cycles > y->cycles) - (x->cycles < y->cycles);
+}
+
+// Per (requester, home, CHA) summary; the index part of the key is ignored
+static void print_summary(timing_buffer_t *buf) {
+    qsort(buf->samples, buf->count, sizeof(timing_sample_t), compare_samples);
+
+    for (uint32_t i = 0; i < buf->count;) {
+        uint32_t key = buf->samples[i].key, j = i;
+        uint64_t sum = 0;
+        for (; j < buf->count && buf->samples[j].key >> 16 == key >> 16; j++) sum += buf->samples[j].cycles;
+
+        double mean = (double)sum / (j - i);
+        printf("%s: S%u->S%u CHA %2u: min %u, median %u, mean %.1f cycles (%.1f ns), %u samples\n",
+               buf->label, TIMING_KEY_REQ(key), TIMING_KEY_HOME(key), TIMING_KEY_CHA(key),
+               buf->samples[i].cycles, buf->samples[i + (j - i) / 2].cycles, mean, timing_ns(mean), j - i);
+        i = j;
+    }
+}
+
+// Hand every buffer's samples to its flush (after freeze_counters_global)
+// and empty it
+void timing_flush_all() {
+    for (int i = 0; i < num_buffers; i++) {
+        timing_buffer_t *buf = &buffers[i];
+        if (!buf->samples) continue;
+        if (buf->dropped) {
+            fprintf(stderr, "Warning: %s dropped %u samples (capacity %u)\n", buf->label, buf->dropped,
+                    buf->capacity);
+        }
+        if (buf->count) {
+            if (buf->flush) {
+                buf->flush(buf);
+            } else if (buf->hist) {
+                for (uint32_t j = 0; j < buf->count; j++) {
+                    uint32_t key = buf->samples[j].key;
+                    latency_hist_record(buf->hist, TIMING_KEY_REQ(key), TIMING_KEY_HOME(key), TIMING_KEY_CHA(key),
+                                        buf->samples[j].cycles);
+                }
+            } else {
+                print_summary(buf);
+            }
+        }
+        buf->count = 0;
+        buf->dropped = 0;
+    }
+}
+
+// Report the histograms gathered since the last report, merging buffers
+// that share a label (one per actor of the same benchmark), and reset them
+void timing_report_all(FILE *out) {
+    latency_hist_t *merged = NULL;
+
+    for (int i = 0; i < num_buffers; i++) {
+        timing_buffer_t *buf = &buffers[i];
+        if (!buf->samples || !buf->hist) continue;
+
+        int first = 1;
+        for (int j = 0; j < i && first; j++) {
+            first = !(buffers[j].samples && buffers[j].hist && strcmp(buffers[j].label, buf->label) == 0);
+        }
+        if (!first) continue;
+
+        if (!merged && !(merged = malloc(sizeof(latency_hist_t)))) {
+            perror("malloc");
+            return;
+        }
+        memset(merged, 0, sizeof(*merged));
+        for (int j = i; j < num_buffers; j++) {
+            if (buffers[j].samples && buffers[j].hist && strcmp(buffers[j].label, buf->label) == 0) {
+                latency_hist_merge(merged, buffers[j].hist);
+            }
+        }
+        latency_hist_report(merged, buf->label, out);
+    }
+
+    for (int i = 0; i < num_buffers; i++) {
+        if (buffers[i].hist) memset(buffers[i].hist, 0, sizeof(latency_hist_t));
+    }
+    free(merged);
+}
+
+// Drop what was recorded since the last flush (warm-up runs)
+void timing_discard_all() {
+    for (int i = 0; i < num_buffers; i++) {
+        buffers[i].count = 0;
+        buffers[i].dropped = 0;
+    }
+}
@@ -0,0 +1,461 @@
+// slice_analyzer.c
+//
+// Offline prediction of how an address pattern spreads over CHAs and L3
+// slice sets, using a CHA map produced by generate_cha_mapped_offsets (or any
+// "offset cha" dump). Offsets are relative to a socket buffer, which is 2MB
+// aligned, so the set index bits [16-6] of an offset match the physical ones.
+//
+// CHAs of offsets missing from the map come from a learned XOR hash, which
+// only exists for a power-of-two CHA count. The supported parts have 24, 28
+// or 40 CHAs: there the CHA view covers the mapped offsets only, and the tool
+// says so rather than scoring on it.
+#include <ctype.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "msr_defs.h"
+
+#define DEFAULT_HOT_RATIO 1.5
+#define MAX_PAD_LINES 16        // Strides tried are stride + k*64, k <= MAX_PAD_LINES
+#define MIN_MAPPED_COVERAGE 0.5 // Below this, CHA statistics are not trusted
+#define HASH_FEATURE_BITS 24    // Address bits [29-6] used by the learned hash
+#define CHA_ID_BITS 8
+
+typedef struct {
+    uint64_t offset;  // Line-aligned offset into the socket buffer
+    int cha;
+} map_entry_t;
+
+typedef struct {
+    map_entry_t *entries;
+    size_t count;
+    int linear_valid;                         // Learned XOR hash reproduces every entry
+    uint32_t linear_rows[CHA_ID_BITS];        // Feature mask per CHA id bit
+    uint32_t linear_const;                    // Constant term per CHA id bit
+    int cha_bits;
+} cha_map_t;
+
+typedef struct {
+    size_t lines;
+    size_t mapped;
+    size_t cha_counts[NUM_CHA];
+    uint32_t *set_counts;      // [L3_SLICE_SETS]
+    uint32_t *cha_set_counts;  // [NUM_CHA][L3_SLICE_SETS]
+} analysis_t;
+
+typedef struct {
+    uint64_t offset;
+    uint64_t stride;
+    uint64_t count;
+    uint64_t size;
+} stride_pattern_t;
+
+static int compare_entries(const void *a, const void *b) {
+    const map_entry_t *x = a, *y = b;
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+static void map_add(cha_map_t *map, size_t *capacity, uint64_t offset, int cha) {
+    if (cha < 0 || cha >= NUM_CHA) return;
+    if (map->count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 4096;
+        map->entries = realloc(map->entries, *capacity * sizeof(map_entry_t));
+        if (!map->entries) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    map->entries[map->count].offset = offset & ~(uint64_t)(CACHE_LINE_SIZE - 1);
+    map->entries[map->count].cha = cha;
+    map->count++;
+}
+
+// Accepts the OFFSET_FILE log ("CHA c on Socket s:" / "Offset: o") or plain
+// "offset cha" pairs, one per line.
+static int load_cha_map(const char *path, int socket_id, cha_map_t *map) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror("Error opening CHA map");
+        return -1;
+    }
+
+    size_t capacity = 0;
+    int cur_cha = -1, cur_socket = -1;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        int cha, sock;
+        long long off;
+        if (sscanf(line, "CHA %d on Socket %d:", &cha, &sock) == 2) {
+            cur_cha = cha;
+            cur_socket = sock;
+        } else if (sscanf(line, "Offset: %lli", &off) == 1) {
+            if (cur_socket == socket_id) map_add(map, &capacity, off, cur_cha);
+        } else if (sscanf(line, "%lli %d", &off, &cha) == 2) {
+            map_add(map, &capacity, off, cha);
+        }
+    }
+    fclose(fp);
+
+    qsort(map->entries, map->count, sizeof(map_entry_t), compare_entries);
+    return 0;
+}
+
+// Try to explain the map with a linear (XOR-of-address-bits) hash per CHA id
+// bit. This holds for parts with a power-of-two slice count only; the others
+// hash through a non-linear stage, so only the recorded offsets are predicted.
+static void learn_linear_hash(cha_map_t *map) {
+    map->linear_valid = 0;
+    map->cha_bits = 0;
+    while ((1 << map->cha_bits) < NUM_CHA) map->cha_bits++;
+    if ((1 << map->cha_bits) != NUM_CHA || map->count < 4 * HASH_FEATURE_BITS) return;
+
+    // Row layout: bits [HASH_FEATURE_BITS-1:0] address features, next bit the
+    // constant term, top bit the target value.
+    const int n_cols = HASH_FEATURE_BITS + 1;
+    uint64_t *rows = malloc(map->count * sizeof(uint64_t));
+    if (!rows) return;
+
+    for (int bit = 0; bit < map->cha_bits; bit++) {
+        for (size_t i = 0; i < map->count; i++) {
+            uint64_t features = (map->entries[i].offset >> 6) & ((1u << HASH_FEATURE_BITS) - 1);
+            uint64_t target = (map->entries[i].cha >> bit) & 1;
+            rows[i] = features | (1ULL << HASH_FEATURE_BITS) | (target << 63);
+        }
+
+        // Gaussian elimination over GF(2)
+        int pivot_row[HASH_FEATURE_BITS + 1];
+        size_t rank = 0;
+        for (int col = 0; col < n_cols; col++) {
+            pivot_row[col] = -1;
+            size_t sel = rank;
+            while (sel < map->count && !((rows[sel] >> col) & 1)) sel++;
+            if (sel == map->count) continue;
+
+            uint64_t tmp = rows[sel];
+            rows[sel] = rows[rank];
+            rows[rank] = tmp;
+            for (size_t i = 0; i < map->count; i++) {
+                if (i != rank && ((rows[i] >> col) & 1)) rows[i] ^= rows[rank];
+            }
+            pivot_row[col] = rank++;
+        }
+
+        // Any leftover row "0 = 1" means the map is not linear in these bits
+        for (size_t i = rank; i < map->count; i++) {
+            if (rows[i] >> 63) {
+                free(rows);
+                return;
+            }
+        }
+
+        uint32_t solution = 0, constant = 0;
+        for (int col = 0; col < n_cols; col++) {
+            if (pivot_row[col] < 0 || !(rows[pivot_row[col]] >> 63)) continue;
+            if (col == HASH_FEATURE_BITS) {
+                constant = 1;
+            } else {
+                solution |= 1u << col;
+            }
+        }
+        map->linear_rows[bit] = solution;
+        if (constant) map->linear_const |= 1u << bit;
+    }
+
+    free(rows);
+    map->linear_valid = 1;
+}
+
+static int predict_cha(const cha_map_t *map, uint64_t offset) {
+    map_entry_t key = {offset & ~(uint64_t)(CACHE_LINE_SIZE - 1), 0};
+    map_entry_t *hit = bsearch(&key, map->entries, map->count, sizeof(map_entry_t), compare_entries);
+    if (hit) return hit->cha;
+
+    if (!map->linear_valid) return -1;
+
+    uint32_t features = (offset >> 6) & ((1u << HASH_FEATURE_BITS) - 1);
+    int cha = 0;
+    for (int bit = 0; bit < map->cha_bits; bit++) {
+        int v = __builtin_parity(features & map->linear_rows[bit]) ^ ((map->linear_const >> bit) & 1);
+        cha |= v << bit;
+    }
+    return cha;
+}
+
+static void analysis_reset(analysis_t *a) {
+    a->lines = 0;
+    a->mapped = 0;
+    memset(a->cha_counts, 0, sizeof(a->cha_counts));
+    memset(a->set_counts, 0, L3_SLICE_SETS * sizeof(uint32_t));
+    memset(a->cha_set_counts, 0, (size_t)NUM_CHA * L3_SLICE_SETS * sizeof(uint32_t));
+}
+
+static void analysis_add(analysis_t *a, const cha_map_t *map, uint64_t offset) {
+    int set = (offset & L3_SLICE_SET_INDEX_MASK) >> 6;
+    int cha = predict_cha(map, offset);
+
+    a->lines++;
+    a->set_counts[set]++;
+    if (cha >= 0) {
+        a->mapped++;
+        a->cha_counts[cha]++;
+        a->cha_set_counts[(size_t)cha * L3_SLICE_SETS + set]++;
+    }
+}
+
+static void analyze_stride(analysis_t *a, const cha_map_t *map, const stride_pattern_t *p) {
+    analysis_reset(a);
+    for (uint64_t i = 0; i < p->count; i++) {
+        uint64_t start = p->offset + i * p->stride;
+        uint64_t first = start & ~(uint64_t)(CACHE_LINE_SIZE - 1);
+        for (uint64_t line = first; line < start + p->size; line += CACHE_LINE_SIZE) {
+            analysis_add(a, map, line);
+        }
+    }
+}
+
+static double cha_imbalance(const analysis_t *a) {
+    if (a->mapped == 0) return 0.0;
+    size_t max = 0;
+    for (int cha = 0; cha < NUM_CHA; cha++) {
+        if (a->cha_counts[cha] > max) max = a->cha_counts[cha];
+    }
+    return max / ((double)a->mapped / NUM_CHA);
+}
+
+// Ratio of the fullest set to the fullest set of a perfectly even spread
+static double set_imbalance(const analysis_t *a) {
+    if (a->lines == 0) return 0.0;
+    uint32_t max = 0;
+    for (int set = 0; set < L3_SLICE_SETS; set++) {
+        if (a->set_counts[set] > max) max = a->set_counts[set];
+    }
+    size_t ideal = (a->lines + L3_SLICE_SETS - 1) / L3_SLICE_SETS;
+    return (double)max / ideal;
+}
+
+static double imbalance_score(const analysis_t *a) {
+    double coverage = a->lines ? (double)a->mapped / a->lines : 0.0;
+    double set_score = set_imbalance(a);
+    if (coverage < MIN_MAPPED_COVERAGE) return set_score;
+    double cha_score = cha_imbalance(a);
+    return cha_score > set_score ? cha_score : set_score;
+}
+
+static void print_report(const analysis_t *a, double hot_ratio) {
+    double coverage = a->lines ? 100.0 * a->mapped / a->lines : 0.0;
+    printf("Lines analyzed: %zu (%zu with a predicted CHA, %.1f%%)\n", a->lines, a->mapped, coverage);
+    if (coverage < 100.0 * MIN_MAPPED_COVERAGE) {
+        printf("Warning: below %.0f%% of the lines have a known CHA; the CHA distribution below covers "
+               "the mapped lines only, and scores use the slice sets alone\n", 100.0 * MIN_MAPPED_COVERAGE);
+    }
+
+    // Per-CHA distribution
+    if (a->mapped > 0) {
+        double mean = (double)a->mapped / NUM_CHA;
+        printf("\n%-5s %10s %8s %8s\n", "CHA", "Lines", "Share", "xMean");
+        printf("%-5s %10s %8s %8s\n", "---", "----------", "--------", "--------");
+        for (int cha = 0; cha < NUM_CHA; cha++) {
+            double ratio = a->cha_counts[cha] / mean;
+            printf("%-5d %10zu %7.2f%% %8.2f%s\n", cha, a->cha_counts[cha],
+                   100.0 * a->cha_counts[cha] / a->mapped, ratio,
+                   ratio >= hot_ratio ? "  HOT" : (a->cha_counts[cha] == 0 ? "  idle" : ""));
+        }
+        printf("CHA imbalance (max/mean): %.2f\n", cha_imbalance(a));
+    }
+
+    // L3 slice set geometry
+    int sets_used = 0;
+    uint32_t max_set = 0;
+    for (int set = 0; set < L3_SLICE_SETS; set++) {
+        if (a->set_counts[set]) sets_used++;
+        if (a->set_counts[set] > max_set) max_set = a->set_counts[set];
+    }
+    printf("\nL3 slice sets used: %d/%d, fullest set holds %u lines (set imbalance %.2f)\n",
+           sets_used, L3_SLICE_SETS, max_set, set_imbalance(a));
+
+    // (CHA, set) pairs holding more lines than the slice associativity
+    size_t over_assoc = 0;
+    uint32_t worst = 0;
+    int worst_cha = -1, worst_set = -1;
+    for (int cha = 0; cha < NUM_CHA; cha++) {
+        for (int set = 0; set < L3_SLICE_SETS; set++) {
+            uint32_t n = a->cha_set_counts[(size_t)cha * L3_SLICE_SETS + set];
+            if (n > L3_ASSOC) over_assoc++;
+            if (n > worst) {
+                worst = n;
+                worst_cha = cha;
+                worst_set = set;
+            }
+        }
+    }
+    if (worst_cha >= 0) {
+        printf("Fullest (CHA, set): (%d, %d) with %u lines; %zu pairs exceed L3_ASSOC=%d\n",
+               worst_cha, worst_set, worst, over_assoc, L3_ASSOC);
+    }
+}
+
+static void suggest_padding(analysis_t *a, const cha_map_t *map, const stride_pattern_t *p) {
+    analyze_stride(a, map, p);
+    double base_score = imbalance_score(a);
+
+    uint64_t best_stride[3] = {0};
+    double best_score[3] = {base_score, base_score, base_score};
+
+    for (int k = 1; k <= MAX_PAD_LINES; k++) {
+        stride_pattern_t padded = *p;
+        padded.stride = p->stride + (uint64_t)k * CACHE_LINE_SIZE;
+        analyze_stride(a, map, &padded);
+        double score = imbalance_score(a);
+
+        for (int r = 0; r < 3; r++) {
+            if (score < best_score[r]) {
+                memmove(&best_score[r + 1], &best_score[r], (2 - r) * sizeof(double));
+                memmove(&best_stride[r + 1], &best_stride[r], (2 - r) * sizeof(uint64_t));
+                best_score[r] = score;
+                best_stride[r] = padded.stride;
+                break;
+            }
+        }
+    }
+
+    printf("\nPadding suggestions (current stride %lu, imbalance %.2f):\n", p->stride, base_score);
+    if (best_stride[0] == 0) {
+        printf("  None of the strides up to +%d lines spread the pattern better.\n", MAX_PAD_LINES);
+        return;
+    }
+    for (int r = 0; r < 3 && best_stride[r]; r++) {
+        printf("  stride %lu (+%lu bytes): imbalance %.2f\n", best_stride[r],
+               best_stride[r] - p->stride, best_score[r]);
+    }
+}
+
+static int parse_stride_pattern(const char *spec, stride_pattern_t *p) {
+    p->offset = 0;
+    p->stride = 0;
+    p->count = 0;
+    p->size = CACHE_LINE_SIZE;
+
+    char *copy = strdup(spec);
+    for (char *tok = strtok(copy, ","); tok; tok = strtok(NULL, ",")) {
+        char *eq = strchr(tok, '=');
+        if (!eq) {
+            fprintf(stderr, "Error: malformed pattern field '%s'\n", tok);
+            free(copy);
+            return -1;
+        }
+        *eq = '\0';
+        uint64_t value = strtoull(eq + 1, NULL, 0);
+        if (strcmp(tok, "offset") == 0) p->offset = value;
+        else if (strcmp(tok, "stride") == 0) p->stride = value;
+        else if (strcmp(tok, "count") == 0) p->count = value;
+        else if (strcmp(tok, "size") == 0) p->size = value;
+        else {
+            fprintf(stderr, "Error: unknown pattern field '%s'\n", tok);
+            free(copy);
+            return -1;
+        }
+    }
+    free(copy);
+
+    if (p->stride == 0 || p->count == 0 || p->size == 0) {
+        fprintf(stderr, "Error: pattern needs non-zero stride, count and size\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int analyze_dump(analysis_t *a, const cha_map_t *map, const char *path, uint64_t base) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror("Error opening address dump");
+        return -1;
+    }
+
+    analysis_reset(a);
+    char line[128];
+    while (fgets(line, sizeof(line), fp)) {
+        char *p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0' || *p == '#') continue;
+        uint64_t addr = strtoull(p, NULL, 0);
+        if (addr < base) continue;
+        analysis_add(a, map, addr - base);
+    }
+    fclose(fp);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [-m map_file] [-s socket] [-t hot_ratio] (-p pattern | -a dump [-b base])\n", prog);
+    printf("  -m  CHA map in %s format or 'offset cha' pairs (default %s)\n", OFFSET_FILE, OFFSET_FILE);
+    printf("  -s  socket whose mapping is used (default 0)\n");
+    printf("  -t  flag CHAs above this multiple of the mean (default %.1f)\n", DEFAULT_HOT_RATIO);
+    printf("  -p  stride pattern: offset=O,stride=S,count=N[,size=B]\n");
+    printf("  -a  address dump, one address per line (decimal or 0x hex)\n");
+    printf("  -b  base subtracted from dumped addresses (default 0)\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *map_path = OFFSET_FILE;
+    const char *pattern = NULL;
+    const char *dump_path = NULL;
+    uint64_t base = 0;
+    int socket_id = 0;
+    double hot_ratio = DEFAULT_HOT_RATIO;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:s:t:p:a:b:h")) != -1) {
+        switch (opt) {
+            case 'm': map_path = optarg; break;
+            case 's': socket_id = atoi(optarg); break;
+            case 't': hot_ratio = atof(optarg); break;
+            case 'p': pattern = optarg; break;
+            case 'a': dump_path = optarg; break;
+            case 'b': base = strtoull(optarg, NULL, 0); break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (!pattern == !dump_path) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    cha_map_t map = {0};
+    if (load_cha_map(map_path, socket_id, &map) != 0) return EXIT_FAILURE;
+    learn_linear_hash(&map);
+    printf("CHA map: %zu lines from %s (socket %d), %s\n", map.count, map_path, socket_id,
+           map.linear_valid ? "linear slice hash learned" : "lookup only");
+    if (!map.linear_valid) {
+        printf("Warning: CHA prediction is unavailable for this part (%d CHAs%s); only offsets listed in "
+               "the map get a CHA\n", NUM_CHA,
+               (NUM_CHA & (NUM_CHA - 1)) ? ", not a power of two" : ", map not linear or too small");
+    }
+
+    analysis_t a;
+    a.set_counts = calloc(L3_SLICE_SETS, sizeof(uint32_t));
+    a.cha_set_counts = calloc((size_t)NUM_CHA * L3_SLICE_SETS, sizeof(uint32_t));
+    if (!a.set_counts || !a.cha_set_counts) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    if (pattern) {
+        stride_pattern_t p;
+        if (parse_stride_pattern(pattern, &p) != 0) return EXIT_FAILURE;
+        analyze_stride(&a, &map, &p);
+        print_report(&a, hot_ratio);
+        suggest_padding(&a, &map, &p);
+    } else {
+        if (analyze_dump(&a, &map, dump_path, base) != 0) return EXIT_FAILURE;
+        print_report(&a, hot_ratio);
+    }
+
+    free(a.set_counts);
+    free(a.cha_set_counts);
+    free(map.entries);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,361 @@
+#include <dirent.h>
+#include <string.h>
+#include "topology.h"
+
+int num_nodes = 0;
+int node_socket[MAX_NODES];
+int socket_nodes[MAX_SOCKETS][MAX_NODES_PER_SOCKET];
+int socket_num_nodes[MAX_SOCKETS] = {0};
+int cpu_node[MAX_CPUS];
+cpu_topo_t cpu_topo[MAX_CPUS];
+int num_cpus = 0;
+
+// Package id of a CPU from sysfs, -1 if unavailable
+static int read_package_id(int cpu_id) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu_id);
+    FILE *file = fopen(path, "r");
+    if (!file) return -1;
+
+    int socket_id = -1;
+    if (fscanf(file, "%d", &socket_id) != 1) socket_id = -1;
+    fclose(file);
+    return socket_id;
+}
+
+// Parse a sysfs cpulist ("0-23,48-71") and tag every CPU with node_id.
+// Returns the first CPU of the list, or -1 if the list is empty.
+static int parse_node_cpulist(int node_id) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node_id);
+    FILE *file = fopen(path, "r");
+    if (!file) return -1;
+
+    char list[1024];
+    if (!fgets(list, sizeof(list), file)) {
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+
+    int first_cpu = -1;
+    for (char *tok = strtok(list, ",\n"); tok; tok = strtok(NULL, ",\n")) {
+        int lo, hi;
+        int n = sscanf(tok, "%d-%d", &lo, &hi);
+        if (n < 1) continue;
+        if (n == 1) hi = lo;
+
+        for (int cpu = lo; cpu <= hi && cpu < MAX_CPUS; cpu++) {
+            cpu_node[cpu] = node_id;
+        }
+        if (first_cpu == -1) first_cpu = lo;
+    }
+    return first_cpu;
+}
+
+// Map sockets to their NUMA nodes. Without SNC every socket has exactly one
+// node; with SNC2/SNC4 each socket exposes two or four.
+int discover_numa_topology() {
+    memset(node_socket, -1, sizeof(node_socket));
+    memset(socket_nodes, -1, sizeof(socket_nodes));
+    memset(socket_num_nodes, 0, sizeof(socket_num_nodes));
+    memset(cpu_node, -1, sizeof(cpu_node));
+    num_nodes = 0;
+
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (!dir) {
+        perror("opendir");
+        return -1;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int node_id;
+        if (strncmp(entry->d_name, "node", 4) != 0 || sscanf(entry->d_name + 4, "%d", &node_id) != 1) {
+            continue;
+        }
+        if (node_id < 0 || node_id >= MAX_NODES) {
+            fprintf(stderr, "Warning: ignoring NUMA node %d (MAX_NODES is %d)\n", node_id, MAX_NODES);
+            continue;
+        }
+
+        if (node_id + 1 > num_nodes) num_nodes = node_id + 1;
+
+        int first_cpu = parse_node_cpulist(node_id);
+        if (first_cpu < 0) continue;  // Memory-only node
+
+        node_socket[node_id] = read_package_id(first_cpu);
+    }
+    closedir(dir);
+
+    // Nodes of each socket in ascending order
+    for (int node = 0; node < num_nodes; node++) {
+        int socket_id = node_socket[node];
+        if (socket_id < 0 || socket_id >= MAX_SOCKETS) continue;
+        if (socket_num_nodes[socket_id] >= MAX_NODES_PER_SOCKET) {
+            fprintf(stderr, "Warning: socket %d has more than %d nodes\n", socket_id, MAX_NODES_PER_SOCKET);
+            continue;
+        }
+        socket_nodes[socket_id][socket_num_nodes[socket_id]++] = node;
+    }
+
+    return num_nodes;
+}
+
+int core_to_node(int core_id) {
+    if (core_id < 0 || core_id >= MAX_CPUS) return -1;
+    return cpu_node[core_id];
+}
+
+int core_to_socket(int core_id) {
+    int node = core_to_node(core_id);
+    return node < 0 ? -1 : node_socket[node];
+}
+
+// Pick the node whose memory serves the requested locality for core_id
+int select_locality_node(int core_id, pool_locality_t locality) {
+    int node = core_to_node(core_id);
+    int socket_id = core_to_socket(core_id);
+    if (node < 0 || socket_id < 0) {
+        fprintf(stderr, "Error: core %d has no known NUMA node\n", core_id);
+        return -1;
+    }
+
+    switch (locality) {
+        case POOL_LOCAL_SNC:
+            return node;
+        case POOL_REMOTE_SNC:
+            for (int i = 0; i < socket_num_nodes[socket_id]; i++) {
+                if (socket_nodes[socket_id][i] != node) return socket_nodes[socket_id][i];
+            }
+            return -1;  // SNC disabled
+        case POOL_REMOTE_SOCKET:
+            for (int s = 1; s < MAX_SOCKETS; s++) {
+                int remote = (socket_id + s) % MAX_SOCKETS;
+                if (socket_num_nodes[remote] > 0) return socket_nodes[remote][0];
+            }
+            return -1;
+    }
+    return -1;
+}
+
+const char *locality_name(pool_locality_t locality) {
+    switch (locality) {
+        case POOL_LOCAL_SNC: return "local SNC";
+        case POOL_REMOTE_SNC: return "same-socket remote SNC";
+        case POOL_REMOTE_SOCKET: return "remote socket";
+    }
+    return "unknown";
+}
+
+void print_numa_topology() {
+    printf("+--------+-------+---------------------+\n");
+    printf("| Socket | Nodes | Node IDs            |\n");
+    printf("+--------+-------+---------------------+\n");
+    for (int s = 0; s < MAX_SOCKETS; s++) {
+        char ids[64] = "";
+        for (int i = 0; i < socket_num_nodes[s]; i++) {
+            char id[8];
+            snprintf(id, sizeof(id), i ? ",%d" : "%d", socket_nodes[s][i]);
+            strncat(ids, id, sizeof(ids) - strlen(ids) - 1);
+        }
+        printf("| %-6d | %-5d | %-19s |\n", s, socket_num_nodes[s], ids);
+    }
+    printf("+--------+-------+---------------------+\n");
+}
+
+// Integer from a sysfs file, -1 if unavailable
+static int read_sysfs_int(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) return -1;
+
+    int value = -1;
+    if (fscanf(file, "%d", &value) != 1) value = -1;
+    fclose(file);
+    return value;
+}
+
+// First CPU and CPU count of a sysfs cpulist file
+static int read_cpulist(const char *path, int *count) {
+    FILE *file = fopen(path, "r");
+    *count = 0;
+    if (!file) return -1;
+
+    char list[1024];
+    int first_cpu = -1;
+    if (fgets(list, sizeof(list), file)) {
+        for (char *tok = strtok(list, ",\n"); tok; tok = strtok(NULL, ",\n")) {
+            int lo, hi;
+            int n = sscanf(tok, "%d-%d", &lo, &hi);
+            if (n < 1) continue;
+            if (n == 1) hi = lo;
+            if (first_cpu == -1 || lo < first_cpu) first_cpu = lo;
+            *count += hi - lo + 1;
+        }
+    }
+    fclose(file);
+    return first_cpu;
+}
+
+// Id of the cache at a level, or its first sharing CPU where the kernel
+// has no id file
+static int read_cache_id(int cpu, int level) {
+    char path[128];
+    for (int index = 0; index < 8; index++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+        int found = read_sysfs_int(path);
+        if (found < 0) break;
+        if (found != level) continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/id", cpu, index);
+        int id = read_sysfs_int(path);
+        if (id >= 0) return id;
+        int count;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+        return read_cpulist(path, &count);
+    }
+    return -1;
+}
+
+// NUMA node of a CPU from its nodeN link; independent of cpu_node[], which
+// the memory startup stage fills in concurrently
+static int read_cpu_node(int cpu) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *dir = opendir(path);
+    if (!dir) return -1;
+
+    int node = -1;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && node < 0) {
+        if (strncmp(entry->d_name, "node", 4) != 0 || sscanf(entry->d_name + 4, "%d", &node) != 1) {
+            node = -1;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+// Package, die, core, SMT siblings, L2/LLC and node of every online CPU
+int discover_cpu_topology() {
+    memset(cpu_topo, -1, sizeof(cpu_topo));
+    num_cpus = 0;
+
+    char path[128];
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++) {
+        cpu_topo_t *t = &cpu_topo[cpu];
+        t->online = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        t->package = read_sysfs_int(path);
+        if (t->package < 0) continue;  // Absent or offline
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/online", cpu);
+        if (read_sysfs_int(path) == 0) continue;
+
+        t->online = 1;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/die_id", cpu);
+        t->die = read_sysfs_int(path);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        t->core = read_sysfs_int(path);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+        t->first_sibling = read_cpulist(path, &t->num_siblings);
+        if (t->first_sibling < 0) {
+            t->first_sibling = cpu;
+            t->num_siblings = 1;
+        }
+        t->node = read_cpu_node(cpu);
+        t->l2_id = read_cache_id(cpu, 2);
+        t->llc_id = read_cache_id(cpu, 3);
+        num_cpus = cpu + 1;
+    }
+    return num_cpus;
+}
+
+int same_physical_core(int cpu_a, int cpu_b) {
+    if (cpu_a < 0 || cpu_b < 0 || cpu_a >= MAX_CPUS || cpu_b >= MAX_CPUS) return 0;
+    return cpu_topo[cpu_a].first_sibling == cpu_topo[cpu_b].first_sibling;
+}
+
+// Lowest online CPU of the socket that passes the filter; physical_only
+// skips SMT siblings other than the first
+static int pick_cpu(int socket_id, int physical_only, int avoid[], int num_avoid, int node, int from_top) {
+    for (int i = 0; i < num_cpus; i++) {
+        int cpu = from_top ? num_cpus - 1 - i : i;
+        const cpu_topo_t *t = &cpu_topo[cpu];
+        if (!t->online || t->package != socket_id) continue;
+        if (physical_only && t->first_sibling != cpu) continue;
+        if (node >= 0 && t->node != node) continue;
+
+        int clash = 0;
+        for (int a = 0; a < num_avoid && !clash; a++) {
+            clash = avoid[a] >= 0 && (physical_only ? same_physical_core(cpu, avoid[a]) : cpu == avoid[a]);
+        }
+        if (!clash) return cpu;
+    }
+    return -1;
+}
+
+// Deterministic roles per socket: the primary is the lowest physical core,
+// the secondary the next physical core (on the primary's SNC node where
+// possible), and the orchestrator the highest physical core that shares
+// neither. Without enough physical cores the orchestrator falls back to any
+// other CPU, then to none.
+void assign_core_roles(int primary[MAX_SOCKETS], int secondary[MAX_SOCKETS], int orchestrator[MAX_SOCKETS]) {
+    if (num_cpus == 0) discover_cpu_topology();
+
+    for (int socket_id = 0; socket_id < MAX_SOCKETS; socket_id++) {
+        primary[socket_id] = pick_cpu(socket_id, 1, NULL, 0, -1, 0);
+        int used[2] = {primary[socket_id], -1};
+        int node = primary[socket_id] >= 0 ? cpu_topo[primary[socket_id]].node : -1;
+        secondary[socket_id] = pick_cpu(socket_id, 1, used, 1, node, 0);
+        if (secondary[socket_id] < 0) secondary[socket_id] = pick_cpu(socket_id, 1, used, 1, -1, 0);
+        used[1] = secondary[socket_id];
+
+        orchestrator[socket_id] = pick_cpu(socket_id, 1, used, 2, -1, 1);
+        if (orchestrator[socket_id] < 0) {
+            orchestrator[socket_id] = pick_cpu(socket_id, 0, used, 2, -1, 1);
+            if (orchestrator[socket_id] >= 0) {
+                fprintf(stderr, "Warning: socket %d orchestrator %d shares a physical core with a measurement core\n",
+                        socket_id, orchestrator[socket_id]);
+            }
+        }
+    }
+}
+
+// Cores a benchmark may load with its own threads: one CPU per physical
+// core of the socket, ascending (so the primary and secondary come first),
+// the orchestrator's core left out. Returns how many were found.
+int socket_worker_cores(int socket_id, int *cores, int max_cores) {
+    if (num_cpus == 0) discover_cpu_topology();
+    if (socket_id < 0 || socket_id >= MAX_SOCKETS) return 0;
+
+    int count = 0;
+    for (int cpu = 0; cpu < num_cpus && count < max_cores; cpu++) {
+        const cpu_topo_t *t = &cpu_topo[cpu];
+        if (!t->online || t->package != socket_id || t->first_sibling != cpu) continue;
+        if (same_physical_core(cpu, orchestrator_cores[socket_id])) continue;
+        cores[count++] = cpu;
+    }
+    return count;
+}
+
+// Roles and where each one sits, for the logs
+void write_core_layout(FILE *fp) {
+    static const char *roles[] = {"primary", "secondary", "orchestrator"};
+    const int *cores[] = {primary_cores, secondary_cores, orchestrator_cores};
+
+    fprintf(fp, "%-12s %-6s %-5s %-5s %-5s %-5s %-6s %-6s %-8s\n", "Role", "Socket", "CPU", "Core", "Die", "Node",
+            "L2", "LLC", "Siblings");
+    for (int socket_id = 0; socket_id < MAX_SOCKETS; socket_id++) {
+        for (int r = 0; r < 3; r++) {
+            int cpu = cores[r][socket_id];
+            if (cpu < 0 || cpu >= MAX_CPUS) {
+                fprintf(fp, "%-12s %-6d %-5s\n", roles[r], socket_id, "-");
+                continue;
+            }
+            const cpu_topo_t *t = &cpu_topo[cpu];
+            fprintf(fp, "%-12s %-6d %-5d %-5d %-5d %-5d %-6d %-6d %-8d\n", roles[r], socket_id, cpu, t->core,
+                    t->die, t->node, t->l2_id, t->llc_id, t->num_siblings);
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "util.h"
+#include "topology.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -21,6 +22,26 @@ uint64_t rdtsc() {
     return (d << 32) | a;
 }
 
+// Physical address of a mapped virtual address from /proc/self/pagemap.
+// Returns 0 if the page is not present or PFNs are hidden (no CAP_SYS_ADMIN).
+uint64_t virt_to_phys(void *addr) {
+    static int pagemap_fd = -1;
+    if (pagemap_fd < 0) {
+        pagemap_fd = open("/proc/self/pagemap", O_RDONLY);
+        if (pagemap_fd < 0) return 0;
+    }
+
+    uint64_t entry;
+    uintptr_t vaddr = (uintptr_t)addr;
+    if (pread(pagemap_fd, &entry, sizeof(entry), (vaddr / PAGE_SIZE) * sizeof(entry)) != sizeof(entry)) {
+        return 0;
+    }
+    if (!(entry & (1ULL << 63))) return 0;  // Not present
+
+    uint64_t pfn = entry & ((1ULL << 55) - 1);
+    return pfn ? pfn * PAGE_SIZE + (vaddr % PAGE_SIZE) : 0;
+}
+
 // Usage: set_process_affinity(primary_cores[socket_id] or secondary_cores[socket_id]);
 void set_process_affinity(int core_id) {
     cpu_set_t cpuset;
@@ -33,74 +54,16 @@ void set_process_affinity(int core_id) {
     }
 }
 
-// Find two cores in each socket and store them as primary and secondary.
+// Assign the primary, secondary and orchestrator core of each socket from
+// the sysfs topology; the same machine always gets the same layout.
 void find_primary_secondary_cores_per_socket() {
-    memset(primary_cores, -1, sizeof(primary_cores));
-    memset(secondary_cores, -1, sizeof(secondary_cores));
-    memset(orchestrator_cores, -1, sizeof(orchestrator_cores));
-    
-    int *socket_cores[MAX_SOCKETS];
-    int socket_core_count[MAX_SOCKETS] = {0};
-    
-    for (int i = 0; i < MAX_SOCKETS; i++) {
-        socket_cores[i] = malloc(256 * sizeof(int));  // Assume max 256 cores per socket
-    }
-
-    DIR *dir = opendir("/sys/devices/system/cpu");
-    if (!dir) {
-        perror("opendir");
-        return;
-    }
-
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-        if (strncmp(entry->d_name, "cpu", 3) == 0) {
-            int cpu_id;
-            if (sscanf(entry->d_name + 3, "%d", &cpu_id) != 1) {
-                continue;
-            }
-
-            char path[128];
-            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu_id);
-            FILE *file = fopen(path, "r");
-            if (!file) {
-                continue;
-            }
-
-            int socket_id;
-            if (fscanf(file, "%d", &socket_id) != 1) {
-                fclose(file);
-                continue;
-            }
-            fclose(file);
-
-            if (socket_id >= 0 && socket_id < MAX_SOCKETS) {
-                if (primary_cores[socket_id] == -1) {
-                    primary_cores[socket_id] = cpu_id;
-                } else if (secondary_cores[socket_id] == -1) {
-                    secondary_cores[socket_id] = cpu_id;
-                }
-                
-                // Store cores for orchestrator selection temporarily
-                socket_cores[socket_id][socket_core_count[socket_id]++] = cpu_id;
-            }
-        }
-    }
-    closedir(dir);
-
-    srand(time(NULL));
-    for (int i = 0; i < MAX_SOCKETS; i++) {
-        if (socket_core_count[i] > 2) {
-            int random_index;
-            do {
-                random_index = rand() % socket_core_count[i];
-            } while (socket_cores[i][random_index] == primary_cores[i] || socket_cores[i][random_index] == secondary_cores[i]);
-            
-            orchestrator_cores[i] = socket_cores[i][random_index];
-        }
-    }
+    discover_cpu_topology();
+    assign_core_roles(primary_cores, secondary_cores, orchestrator_cores);
+    print_core_roles();
+}
 
-    // Print cores per socket as a table
+// Print cores per socket as a table
+void print_core_roles() {
     printf("+--------+---------------+----------------+-------------------+\n");
     printf("| Socket | Primary Core  | Secondary Core | Orchestrator Core |\n");
     printf("+--------+---------------+----------------+-------------------+\n");
@@ -108,11 +71,6 @@ void find_primary_secondary_cores_per_socket() {
         printf("| %-6d | %-13d | %-14d | %-17d |\n", i, primary_cores[i], secondary_cores[i], orchestrator_cores[i]);
     }
     printf("+--------+---------------+----------------+-------------------+\n");
-
-    // Free allocated memory
-    for (int i = 0; i < MAX_SOCKETS; i++) {
-        free(socket_cores[i]);
-    }
 }
 
 void execute_on_socket_core(int socket_id, int use_secondary, void (*func)(void *), void *arg, int old_core_id) {